@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+// Host tool rendering the assets for the default look at build time, so the
+// plugin doesn't need to blur shadows or parse icons for it at runtime.
+//
+// Usage: qadwaitaassetgen <output header> <icon theme directory>
+
+#include "qadwaitaassets.h"
+#include "qadwaitaicontheme.h"
+#include "qadwaitalogging.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#include <QtSvg/QSvgRenderer>
+
+// Border colors of active windows, light and dark
+static const QRgb ceShadowColors[] = { 0xffdbdbdb, 0xff3b3b3b };
+static const qreal ceScales[] = { 1.0, 1.25, 1.5, 2.0 };
+static const char *const ceIconNames[] = { "window-close-symbolic", "window-minimize-symbolic",
+                                           "window-maximize-symbolic", "window-restore-symbolic" };
+
+static void writeAsset(QTextStream &stream, QStringList *assets, const QString &name, QRgb color,
+                       qreal scale, const QImage &image)
+{
+    const QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QByteArray data;
+    for (int y = 0; y < source.height(); ++y)
+        data.append(reinterpret_cast<const char *>(source.constScanLine(y)), source.width() * 4);
+    const QByteArray compressed = qCompress(data, 9);
+
+    const QString dataName = QString("ceBakedData%1").arg(assets->size());
+    stream << "static constexpr unsigned char " << dataName << "[] = {";
+    for (int i = 0; i < compressed.size(); ++i) {
+        if (i % 16 == 0)
+            stream << "\n    ";
+        stream << "0x" << QString::number(uchar(compressed.at(i)), 16) << ",";
+    }
+    stream << "\n};\n";
+
+    assets->append(QString("    { \"%1\", 0x%2, %3, %4, %5, %6, %7 },")
+                           .arg(name)
+                           .arg(color, 8, 16, QLatin1Char('0'))
+                           .arg(scale)
+                           .arg(source.width())
+                           .arg(source.height())
+                           .arg(dataName)
+                           .arg(compressed.size()));
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() != 3) {
+        qWarning("Usage: qadwaitaassetgen <output header> <icon theme directory>");
+        return 1;
+    }
+
+    QFile file(arguments.at(1));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning("Failed to open %s", qPrintable(file.fileName()));
+        return 1;
+    }
+
+    QTextStream stream(&file);
+    stream << "// Generated by qadwaitaassetgen, do not edit\n";
+
+    QStringList assets;
+    for (const QRgb color : ceShadowColors) {
+        for (const qreal scale : ceScales) {
+            writeAsset(stream, &assets, QLatin1String("shadow"), color, scale,
+                       QAdwaitaAssets::renderShadowTiles(QColor::fromRgba(color), scale));
+        }
+    }
+
+    // Icons are optional, the plugin loads them at runtime when they are not baked
+    QAdwaitaIconTheme iconTheme({ arguments.at(2) });
+    for (const char *iconName : ceIconNames) {
+        const QString iconPath =
+                iconTheme.findIconPath({ QLatin1String("Adwaita") }, QLatin1String(iconName));
+        if (iconPath.isEmpty()) {
+            qWarning("Not baking %s, it was not found in %s", iconName,
+                     qPrintable(arguments.at(2)));
+            continue;
+        }
+
+        QSvgRenderer renderer(iconPath);
+        if (!renderer.isValid()) {
+            qWarning("Not baking %s, failed to load %s", iconName, qPrintable(iconPath));
+            continue;
+        }
+
+        for (const qreal scale : ceScales) {
+            writeAsset(stream, &assets, QLatin1String(iconName), 0, scale,
+                       QAdwaitaAssets::renderIconMask(&renderer, scale));
+        }
+    }
+
+    stream << "\nstatic constexpr QAdwaitaBakedAsset ceBakedAssets[] = {\n";
+    stream << assets.join(QLatin1Char('\n')) << "\n};\n";
+
+    return 0;
+}
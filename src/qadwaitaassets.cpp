@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitaassets.h"
+
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPath>
+
+#include <QtSvg/QSvgRenderer>
+
+Q_DECL_IMPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality,
+                                bool alphaOnly, int transposed = 0);
+
+// Renders a small window shape with the same blur as a full window would get.
+// The corners of the result are used as they are and the single row/column in
+// the middle is stretched along the window edges.
+QImage QAdwaitaAssets::renderShadowTiles(const QColor &color, qreal devicePixelRatio)
+{
+    const int size = 2 * ceShadowsTileSize + 1;
+    const QRect rect(0, 0, size, size);
+
+    // Blur in device pixels, qt_blurImage() doesn't respect device pixel ratio
+    QImage backgroundImage(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    backgroundImage.fill(0);
+    {
+        QRect topHalf = rect.translated(ceShadowsWidth, ceShadowsWidth);
+        topHalf.setSize(QSize(size - (2 * ceShadowsWidth), size / 2));
+
+        QRect bottomHalf = rect.translated(ceShadowsWidth, size / 2);
+        bottomHalf.setSize(QSize(size - (2 * ceShadowsWidth), (size / 2) - ceShadowsWidth));
+
+        QPainter tmpPainter(&backgroundImage);
+        tmpPainter.scale(devicePixelRatio, devicePixelRatio);
+        tmpPainter.setBrush(color);
+        tmpPainter.drawRoundedRect(topHalf, ceCornerRadius, ceCornerRadius);
+        tmpPainter.drawRect(bottomHalf);
+        tmpPainter.end();
+    }
+
+    QImage blurredImage(backgroundImage.size(), QImage::Format_ARGB32_Premultiplied);
+    blurredImage.fill(0);
+    {
+        QPainter blurPainter(&blurredImage);
+        qt_blurImage(&blurPainter, backgroundImage, ceShadowsBlurRadius * devicePixelRatio, false,
+                     false);
+        blurPainter.end();
+    }
+    backgroundImage = blurredImage;
+
+    QPainter backgroundPainter(&backgroundImage);
+    backgroundPainter.scale(devicePixelRatio, devicePixelRatio);
+    backgroundPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+    backgroundPainter.fillRect(rect.marginsRemoved(QMargins(8, 8, 8, 8)), QColor(0, 0, 0, 160));
+    backgroundPainter.end();
+
+    backgroundImage.setDevicePixelRatio(devicePixelRatio);
+    return backgroundImage;
+}
+
+QImage QAdwaitaAssets::renderIconMask(QSvgRenderer *renderer, qreal devicePixelRatio)
+{
+    const QRect rect(0, 0, ceIconSize, ceIconSize);
+    QImage mask(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    mask.setDevicePixelRatio(devicePixelRatio);
+    mask.fill(Qt::transparent);
+
+    QPainter painter(&mask);
+    painter.setRenderHints(QPainter::Antialiasing, true);
+    renderer->render(&painter, rect);
+    painter.end();
+
+    return mask;
+}
+
+// Top of the titlebar at its narrowest width, everything below is straight
+// and can be filled without antialiasing
+QImage QAdwaitaAssets::renderTitlebarCornerMask(bool border, qreal devicePixelRatio)
+{
+    const int width = 2 * ceTitlebarCapWidth + 1;
+    QImage mask(QSize(width, ceTitlebarCapWidth) * devicePixelRatio,
+                QImage::Format_ARGB32_Premultiplied);
+    mask.setDevicePixelRatio(devicePixelRatio);
+    mask.fill(Qt::transparent);
+
+    QPainterPath path;
+    path.addRoundedRect(QRectF(0.5, 0.5, width - 1, 2 * width), ceCornerRadius, ceCornerRadius);
+
+    QPainter painter(&mask);
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (border)
+        painter.strokePath(path, QPen(Qt::white));
+    else
+        painter.fillPath(path.simplified(), Qt::white);
+    painter.end();
+
+    return mask;
+}
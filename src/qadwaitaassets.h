@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_ASSETS_H
+#define QADWAITA_ASSETS_H
+
+#include <QtGui/QColor>
+#include <QtGui/QImage>
+
+class QSvgRenderer;
+
+static constexpr int ceCornerRadius = 12;
+static constexpr int ceIconSize = 16;
+static constexpr int ceShadowsWidth = 10;
+static constexpr int ceShadowsBlurRadius = 12;
+// Corner tile of the shadow nine-patch, it has to cover the shadow, the rounded
+// corner and enough of the blur falloff for the edge strips to be uniform
+static constexpr int ceShadowsTileSize =
+        ceShadowsWidth + ceCornerRadius + 2 * ceShadowsBlurRadius;
+// Rounded ends of the titlebar, only the column between them is stretched
+static constexpr int ceTitlebarCapWidth = ceCornerRadius + 1;
+
+// Images the decorations are composed from which depend only on a few parameters.
+// The ones for the default look are rendered at build time and baked into the
+// plugin, anything else is rendered at runtime.
+class QAdwaitaAssets
+{
+public:
+    static QImage renderShadowTiles(const QColor &color, qreal devicePixelRatio);
+    static QImage renderIconMask(QSvgRenderer *renderer, qreal devicePixelRatio);
+    // Coverage of the titlebar background or border along its rounded top edge
+    static QImage renderTitlebarCornerMask(bool border, qreal devicePixelRatio);
+
+    // Return a null image when there is no baked asset for given parameters
+    static QImage bakedShadowTiles(const QColor &color, qreal devicePixelRatio);
+    static QImage bakedIconMask(const QString &iconName, qreal devicePixelRatio);
+};
+
+#endif // QADWAITA_ASSETS_H
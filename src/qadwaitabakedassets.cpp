@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitaassets.h"
+
+#ifdef HAS_BAKED_ASSETS
+#  include <QtCore/QByteArray>
+#  include <QtCore/QtMath>
+
+struct QAdwaitaBakedAsset
+{
+    // "shadow" for shadow tiles, icon name for icon masks
+    const char *name;
+    QRgb color;
+    qreal scale;
+    int width;
+    int height;
+    // Compressed with qCompress()
+    const unsigned char *data;
+    int size;
+};
+
+// Generated by qadwaitaassetgen at build time
+#  include "qadwaitabakedassets_data.h"
+
+static QImage bakedImage(const char *name, QRgb color, qreal devicePixelRatio)
+{
+    for (const QAdwaitaBakedAsset &asset : ceBakedAssets) {
+        if (qstrcmp(asset.name, name) != 0 || asset.color != color
+            || !qFuzzyCompare(asset.scale, devicePixelRatio))
+            continue;
+
+        const QByteArray data = qUncompress(asset.data, asset.size);
+        if (data.size() != asset.width * asset.height * 4)
+            return QImage();
+
+        QImage image(reinterpret_cast<const uchar *>(data.constData()), asset.width, asset.height,
+                     QImage::Format_ARGB32_Premultiplied);
+        // Detach from the temporary data
+        image = image.copy();
+        image.setDevicePixelRatio(devicePixelRatio);
+        return image;
+    }
+
+    return QImage();
+}
+
+QImage QAdwaitaAssets::bakedShadowTiles(const QColor &color, qreal devicePixelRatio)
+{
+    return bakedImage("shadow", color.rgba(), devicePixelRatio);
+}
+
+QImage QAdwaitaAssets::bakedIconMask(const QString &iconName, qreal devicePixelRatio)
+{
+    return bakedImage(iconName.toLatin1().constData(), 0, devicePixelRatio);
+}
+#else
+QImage QAdwaitaAssets::bakedShadowTiles(const QColor &color, qreal devicePixelRatio)
+{
+    Q_UNUSED(color)
+    Q_UNUSED(devicePixelRatio)
+    return QImage();
+}
+
+QImage QAdwaitaAssets::bakedIconMask(const QString &iconName, qreal devicePixelRatio)
+{
+    Q_UNUSED(iconName)
+    Q_UNUSED(devicePixelRatio)
+    return QImage();
+}
+#endif
@@ -0,0 +1,790 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#include "qadwaitadecorationrenderer.h"
+#include "qadwaitaassets.h"
+#include "qadwaitalayercache.h"
+
+#include <QtGui/QFontMetrics>
+#include <QtGui/QIcon>
+#include <QtGui/QPainter>
+#include <QtGui/QTextOption>
+
+#include <QtSvg/QSvgRenderer>
+
+static constexpr int ceButtonSpacing = 12;
+static constexpr int ceButtonWidth = 24;
+static constexpr int ceTitlebarHeight = 38;
+static constexpr int ceWindowBorderWidth = 1;
+
+static QMap<QAdwaitaDecorationRenderer::ButtonIcon, QString> buttonMap = {
+    { QAdwaitaDecorationRenderer::CloseIcon, QStringLiteral("window-close-symbolic") },
+    { QAdwaitaDecorationRenderer::MinimizeIcon, QStringLiteral("window-minimize-symbolic") },
+    { QAdwaitaDecorationRenderer::MaximizeIcon, QStringLiteral("window-maximize-symbolic") },
+    { QAdwaitaDecorationRenderer::RestoreIcon, QStringLiteral("window-restore-symbolic") }
+};
+
+#ifdef HAS_QT6_SUPPORT
+static void drawShadowTiles(QPainter *painter, const QRect &rect, const QPixmap &tiles)
+{
+    const qreal dpr = tiles.devicePixelRatio();
+    const int size = 2 * ceShadowsTileSize + 1;
+
+    // Source rects are in pixmap pixels, tiles are defined in logical pixels
+    auto source = [dpr](int x, int y, int width, int height) {
+        return QRectF(x * dpr, y * dpr, width * dpr, height * dpr);
+    };
+
+    const int tileWidth = qMin(ceShadowsTileSize, rect.width() / 2);
+    const int tileHeight = qMin(ceShadowsTileSize, rect.height() / 2);
+    const int edgeWidth = rect.width() - (2 * tileWidth);
+    const int edgeHeight = rect.height() - (2 * tileHeight);
+    const int left = rect.left();
+    const int top = rect.top();
+    const int right = rect.left() + rect.width() - tileWidth;
+    const int bottom = rect.top() + rect.height() - tileHeight;
+
+    // Corners
+    painter->drawPixmap(QRectF(left, top, tileWidth, tileHeight), tiles,
+                        source(0, 0, tileWidth, tileHeight));
+    painter->drawPixmap(QRectF(right, top, tileWidth, tileHeight), tiles,
+                        source(size - tileWidth, 0, tileWidth, tileHeight));
+    painter->drawPixmap(QRectF(left, bottom, tileWidth, tileHeight), tiles,
+                        source(0, size - tileHeight, tileWidth, tileHeight));
+    painter->drawPixmap(QRectF(right, bottom, tileWidth, tileHeight), tiles,
+                        source(size - tileWidth, size - tileHeight, tileWidth, tileHeight));
+
+    // Edges
+    if (edgeWidth > 0) {
+        painter->drawPixmap(QRectF(left + tileWidth, top, edgeWidth, tileHeight), tiles,
+                            source(ceShadowsTileSize, 0, 1, tileHeight));
+        painter->drawPixmap(QRectF(left + tileWidth, bottom, edgeWidth, tileHeight), tiles,
+                            source(ceShadowsTileSize, size - tileHeight, 1, tileHeight));
+    }
+    if (edgeHeight > 0) {
+        painter->drawPixmap(QRectF(left, top + tileHeight, tileWidth, edgeHeight), tiles,
+                            source(0, ceShadowsTileSize, tileWidth, 1));
+        painter->drawPixmap(QRectF(right, top + tileHeight, tileWidth, edgeHeight), tiles,
+                            source(size - tileWidth, ceShadowsTileSize, tileWidth, 1));
+    }
+}
+#endif
+
+static QImage colorizedMask(const QImage &mask, const QColor &color)
+{
+    QImage image = mask;
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+    painter.fillRect(image.rect(), color);
+    painter.end();
+    return image;
+}
+
+// Titlebar outline at its narrowest width, starting one pixel above the
+// titlebar so the top border is included. Only the rounded corners come from
+// pre-rasterized coverage masks, the rest are plain rects.
+static QPixmap renderTitlebarSlices(const QColor &backgroundColor, const QColor &borderColor,
+                                    const QImage &fillMask, const QImage &borderMask, int height,
+                                    qreal dpr)
+{
+    const int width = 2 * ceTitlebarCapWidth + 1;
+
+    QImage image(QSize(width, height) * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    // Straight edges only fall between device pixels with fractional scaling
+    painter.setRenderHint(QPainter::Antialiasing, dpr != static_cast<int>(dpr));
+
+    const qreal cornerHeight = fillMask.height() / dpr;
+    painter.drawImage(QPointF(), colorizedMask(fillMask, backgroundColor));
+    painter.drawImage(QPointF(), colorizedMask(borderMask, borderColor));
+    painter.fillRect(QRectF(0.5, cornerHeight, width - 1, height - cornerHeight), backgroundColor);
+    painter.fillRect(QRectF(0, cornerHeight, 1, height - cornerHeight), borderColor);
+    painter.fillRect(QRectF(width - 1, cornerHeight, 1, height - cornerHeight), borderColor);
+    painter.end();
+
+    return QPixmap::fromImage(image);
+}
+
+// Bottom edge of the window border the way the rasterizer strokes it, including
+// the beveled corners, in a single row to be stretched like the titlebar
+static QPixmap renderBorderBottomSlices(const QColor &borderColor, qreal dpr)
+{
+    const int width = 2 * ceTitlebarCapWidth + 1;
+
+    QImage image(QSize(width, 1) * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+
+    // Same outline as the window border, with its bottom edge at the top of the image
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(borderColor);
+    painter.drawRect(QRectF(0.5, -1, width - 1, 1));
+    painter.end();
+
+    return QPixmap::fromImage(image);
+}
+
+static void drawTitlebarSlices(QPainter *painter, const QRect &rect, const QPixmap &slices)
+{
+    const qreal dpr = slices.devicePixelRatio();
+    const int size = 2 * ceTitlebarCapWidth + 1;
+
+    // Source rects are in pixmap pixels, slices are defined in logical pixels
+    auto source = [dpr](int x, int width, int height) {
+        return QRectF(x * dpr, 0, width * dpr, height * dpr);
+    };
+
+    const int capWidth = qMin(ceTitlebarCapWidth, rect.width() / 2);
+    const int middleWidth = rect.width() - (2 * capWidth);
+    const int height = rect.height();
+    const int right = rect.left() + rect.width() - capWidth;
+
+    painter->drawPixmap(QRectF(rect.left(), rect.top(), capWidth, height), slices,
+                        source(0, capWidth, height));
+    painter->drawPixmap(QRectF(right, rect.top(), capWidth, height), slices,
+                        source(size - capWidth, capWidth, height));
+    if (middleWidth > 0) {
+        painter->drawPixmap(QRectF(rect.left() + capWidth, rect.top(), middleWidth, height), slices,
+                            source(ceTitlebarCapWidth, 1, height));
+    }
+}
+
+QAdwaitaDecorationRenderer::QAdwaitaDecorationRenderer(bool useBakedIcons, QObject *parent)
+    : QObject(parent), m_layerCache(QAdwaitaLayerCache::instance()), m_useBakedIcons(useBakedIcons)
+{
+    connect(m_layerCache.get(), &QAdwaitaLayerCache::shadowTilesRendered, this,
+            &QAdwaitaDecorationRenderer::shadowTilesRendered);
+    connect(m_layerCache.get(), &QAdwaitaLayerCache::iconMaskRendered, this,
+            &QAdwaitaDecorationRenderer::iconMaskRendered);
+
+    QTextOption option(Qt::AlignHCenter | Qt::AlignVCenter);
+    option.setWrapMode(QTextOption::NoWrap);
+    m_titleLayout.text.setTextOption(option);
+    m_titleLayout.text.setTextFormat(Qt::PlainText);
+}
+
+#ifdef HAS_QT6_SUPPORT
+QMargins QAdwaitaDecorationRenderer::margins(bool maximized, Qt::Edges tiledEdges)
+{
+    // Maximized windows don't have anything around, no shadows, border, etc.
+    if (maximized)
+        return QMargins(0, ceTitlebarHeight, 0, 0);
+
+    // Since all sides (left, right, bottom) are going to be same
+    const int sideMargins = ceShadowsWidth + ceWindowBorderWidth;
+    const int topMargins = ceTitlebarHeight + sideMargins;
+
+    return QMargins(tiledEdges.testFlag(Qt::LeftEdge) ? 0 : sideMargins,
+                    tiledEdges.testFlag(Qt::TopEdge) ? ceTitlebarHeight : topMargins,
+                    tiledEdges.testFlag(Qt::RightEdge) ? 0 : sideMargins,
+                    tiledEdges.testFlag(Qt::BottomEdge) ? 0 : sideMargins);
+}
+
+QMargins QAdwaitaDecorationRenderer::shadowMargins(bool maximized, Qt::Edges tiledEdges)
+{
+    if (maximized)
+        return QMargins();
+
+    return QMargins(tiledEdges.testFlag(Qt::LeftEdge) ? 0 : ceShadowsWidth,
+                    tiledEdges.testFlag(Qt::TopEdge) ? 0 : ceShadowsWidth,
+                    tiledEdges.testFlag(Qt::RightEdge) ? 0 : ceShadowsWidth,
+                    tiledEdges.testFlag(Qt::BottomEdge) ? 0 : ceShadowsWidth);
+}
+#else
+QMargins QAdwaitaDecorationRenderer::margins(bool maximized, Qt::Edges tiledEdges)
+{
+    Q_UNUSED(tiledEdges)
+
+    // Maximized windows don't have anything around, no shadows, border, etc.
+    if (maximized)
+        return QMargins(0, ceTitlebarHeight, 0, 0);
+
+    return QMargins(ceWindowBorderWidth, ceWindowBorderWidth + ceTitlebarHeight,
+                    ceWindowBorderWidth, ceWindowBorderWidth);
+}
+
+QMargins QAdwaitaDecorationRenderer::shadowMargins(bool maximized, Qt::Edges tiledEdges)
+{
+    Q_UNUSED(maximized)
+    Q_UNUSED(tiledEdges)
+
+    // No shadows without the decoration margins backported from Qt 6
+    return QMargins();
+}
+#endif
+
+QAdwaitaDecorationRenderer::Geometry QAdwaitaDecorationRenderer::geometry(const State &state)
+{
+    Geometry geometry;
+    geometry.margins = margins(state.maximized, state.tiledEdges);
+    geometry.shadowMargins = shadowMargins(state.maximized, state.tiledEdges);
+    geometry.surfaceRect = QRect(QPoint(), state.size);
+
+    const QMargins &m = geometry.margins;
+    const QMargins &shadows = geometry.shadowMargins;
+    for (const Button button : { Close, Maximize, Minimize }) {
+        int xPos;
+        const int btnPos = state.buttons.value(button);
+
+        if (state.placement == Right) {
+            xPos = geometry.surfaceRect.width();
+            xPos -= ceButtonWidth * btnPos;
+            xPos -= ceButtonSpacing * btnPos;
+            xPos -= shadows.right();
+        } else {
+            xPos = 0;
+            xPos += ceButtonWidth * btnPos;
+            xPos += ceButtonSpacing * btnPos;
+            xPos += shadows.left();
+            // We are painting from the left to the right so the real
+            // position doesn't need to by moved by the size of the button.
+            xPos -= ceButtonWidth;
+        }
+
+        const int yPos = (m.top() + m.bottom() - ceButtonWidth) / 2;
+        geometry.buttonRects.insert(button, QRectF(xPos, yPos, ceButtonWidth, ceButtonWidth));
+    }
+
+    geometry.titleBarRect =
+            QRect(m.left(), m.bottom(), geometry.surfaceRect.width(), m.top() - m.bottom());
+    geometry.titleRect = geometry.titleBarRect;
+    const QRectF minimizeRect = geometry.buttonRects.value(Minimize);
+    if (state.placement == Right) {
+        geometry.titleRect.setLeft(m.left());
+        geometry.titleRect.setRight(static_cast<int>(minimizeRect.left()) - 8);
+    } else {
+        geometry.titleRect.setLeft(static_cast<int>(minimizeRect.right()) + 8);
+        geometry.titleRect.setRight(geometry.surfaceRect.width() - m.right());
+    }
+
+    // Everything is opaque except for shadows and rounded corners, and the content
+    // in case it's translucent
+    const QRect frameRect = geometry.surfaceRect.marginsRemoved(shadows);
+    geometry.opaqueRegion = frameRect;
+    if (!state.maximized && !state.tiledEdges) {
+        const QSize cornerSize(ceCornerRadius + 1, ceCornerRadius + 1);
+        geometry.opaqueRegion -= QRect(frameRect.topLeft(), cornerSize);
+        geometry.opaqueRegion -=
+                QRect(QPoint(frameRect.right() - ceCornerRadius, frameRect.top()), cornerSize);
+    }
+    if (state.translucent)
+        geometry.opaqueRegion -= geometry.surfaceRect.marginsRemoved(m);
+
+    return geometry;
+}
+
+QMap<QAdwaitaDecorationRenderer::ColorType, QColor>
+QAdwaitaDecorationRenderer::colors(bool useDarkColors)
+{
+    return { { Background, useDarkColors ? QColor(0x303030) : QColor(0xffffff) },
+             { BackgroundInactive, useDarkColors ? QColor(0x242424) : QColor(0xfafafa) },
+             { Foreground, useDarkColors ? QColor(0xffffff) : QColor(0x2e2e2e) },
+             { ForegroundInactive, useDarkColors ? QColor(0x919191) : QColor(0x949494) },
+             { Border, useDarkColors ? QColor(0x3b3b3b) : QColor(0xdbdbdb) },
+             { BorderInactive, useDarkColors ? QColor(0x303030) : QColor(0xdbdbdb) },
+             { ButtonBackground, useDarkColors ? QColor(0x444444) : QColor(0xebebeb) },
+             { ButtonBackgroundInactive, useDarkColors ? QColor(0x2e2e2e) : QColor(0xf0f0f0) },
+             { HoveredButtonBackground, useDarkColors ? QColor(0x4f4f4f) : QColor(0xe0e0e0) },
+             { PressedButtonBackground, useDarkColors ? QColor(0x6e6e6e) : QColor(0xc2c2c2) } };
+}
+
+QStringList QAdwaitaDecorationRenderer::iconNames()
+{
+    return buttonMap.values();
+}
+
+void QAdwaitaDecorationRenderer::setIcons(const QHash<QString, QByteArray> &icons)
+{
+    m_icons.clear();
+    m_iconRenderers.clear();
+    for (auto mapIt = buttonMap.constBegin(); mapIt != buttonMap.constEnd(); mapIt++) {
+        auto iconIt = icons.constFind(mapIt.value());
+        // Still being loaded
+        if (iconIt == icons.constEnd())
+            continue;
+
+        const QByteArray svgIcon = iconIt.value();
+        m_icons.insert(mapIt.key(), svgIcon);
+
+        // Parse only once, icons are recolored when rendered into masks
+        if (!svgIcon.isEmpty()) {
+            auto renderer = std::make_shared<QSvgRenderer>(svgIcon);
+            if (renderer->isValid())
+                m_iconRenderers.insert(mapIt.key(), renderer);
+        }
+    }
+    m_pendingIconMasks.clear();
+    m_iconPixmaps.clear();
+    m_buttonPixmaps.clear();
+}
+
+void QAdwaitaDecorationRenderer::paint(QPainter *painter, const State &state,
+                                       const Geometry &geometry)
+{
+    // Layers rendered with previous colors are not going to be used again
+    if (m_colors != state.colors) {
+        m_colors = state.colors;
+        m_titlebarSlices.clear();
+        m_borderBottomSlices.clear();
+        m_buttonPixmaps.clear();
+    }
+
+    const QColor borderColor = state.colors.value(state.active ? Border : BorderInactive);
+    const QColor backgroundColor =
+            state.colors.value(state.active ? Background : BackgroundInactive);
+    const QColor foregroundColor =
+            state.colors.value(state.active ? Foreground : ForegroundInactive);
+
+    if (state.maximized || state.tiledEdges != Qt::Edges()) {
+        // Most windows are maximized, nothing but opaque rects without antialiasing
+        paintSquareTitlebar(painter, geometry, backgroundColor, borderColor);
+    } else {
+        paintRoundedTitlebar(painter, geometry, backgroundColor, borderColor, state.active);
+    }
+
+    paintTitle(painter, state, geometry, foregroundColor);
+
+    for (const Button button : { Close, Maximize, Minimize }) {
+        if (state.buttons.contains(button))
+            paintButton(painter, state, geometry, button);
+    }
+}
+
+void QAdwaitaDecorationRenderer::paintSquareTitlebar(QPainter *painter, const Geometry &geometry,
+                                                     const QColor &backgroundColor,
+                                                     const QColor &borderColor)
+{
+    const QRect &surfaceRect = geometry.surfaceRect;
+    const QMargins &margins = geometry.margins;
+    const QMargins &shadowMargins = geometry.shadowMargins;
+
+    // Same outline as the rounded titlebar gets with square corners, in whole pixels
+    const int left = shadowMargins.left();
+    const int right = surfaceRect.width() - shadowMargins.right() - 1;
+    const int top = shadowMargins.top() - 1;
+    const int bottom = shadowMargins.top() + margins.top() - 1;
+    const int titlebarBottom = margins.top() - 1;
+    const int width = right - left + 1;
+
+    painter->fillRect(QRect(left, top, width, titlebarBottom - top + 1), backgroundColor);
+    painter->fillRect(QRect(left, top, width, 1), borderColor);
+    painter->fillRect(QRect(left, top, 1, titlebarBottom - top + 1), borderColor);
+    painter->fillRect(QRect(right, top, 1, titlebarBottom - top + 1), borderColor);
+    if (bottom <= titlebarBottom) {
+        painter->fillRect(QRect(left, bottom, width, 1), borderColor);
+    } else {
+        // Top of the window border is centered between the titlebar and the content
+        // and gets half of its color blended into the last titlebar row
+        const QColor separatorColor = QColor::fromRgbF(
+                (backgroundColor.redF() + borderColor.redF()) / 2,
+                (backgroundColor.greenF() + borderColor.greenF()) / 2,
+                (backgroundColor.blueF() + borderColor.blueF()) / 2);
+        painter->fillRect(QRect(left + 1, titlebarBottom, width - 2, 1), separatorColor);
+    }
+
+    // Window border, only visible along sides which are not tiled
+    const int borderBottom = surfaceRect.height() - margins.bottom();
+    painter->fillRect(QRect(left, margins.top(), 1, borderBottom - margins.top() + 1), borderColor);
+    painter->fillRect(QRect(right, margins.top(), 1, borderBottom - margins.top() + 1),
+                      borderColor);
+    painter->fillRect(QRect(left, borderBottom, width, 1), borderColor);
+}
+
+void QAdwaitaDecorationRenderer::paintRoundedTitlebar(QPainter *painter, const Geometry &geometry,
+                                                      const QColor &backgroundColor,
+                                                      const QColor &borderColor, bool active)
+{
+    const QRect &surfaceRect = geometry.surfaceRect;
+    const QMargins &margins = geometry.margins;
+    const QMargins &shadowMargins = geometry.shadowMargins;
+    const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+    // Straight edges only fall between device pixels with fractional scaling
+    const bool fractionalScale = devicePixelRatio != static_cast<int>(devicePixelRatio);
+
+    const bool antialiasing = painter->testRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::Antialiasing, fractionalScale);
+
+#ifdef HAS_QT6_SUPPORT
+    // Shadows
+    if (active) {
+        updateShadowPixmap(borderColor, devicePixelRatio);
+
+        const QRect shadowRect(QPoint(), surfaceRect.size());
+        painter->save();
+        painter->setClipRegion(QRegion(shadowRect).subtracted(shadowRect.marginsRemoved(margins)),
+                               Qt::IntersectClip);
+        drawShadowTiles(painter, shadowRect, m_shadowPixmap);
+        painter->restore();
+    }
+#else
+    Q_UNUSED(active)
+#endif
+
+    // Titlebar and window border
+    const QPointF topLeft = { shadowMargins.left() + 0.5, shadowMargins.top() - 0.5 };
+    const int titleBarWidth =
+            surfaceRect.width() - shadowMargins.left() - shadowMargins.right() - 0.5;
+    const int borderRectHeight = surfaceRect.height() - margins.top() - margins.bottom() + 0.5;
+
+    // Resizing only stretches the middle of the titlebar
+    const int slicesHeight = margins.top() - shadowMargins.top() + 1;
+    const auto key = std::make_tuple(backgroundColor.rgba(), borderColor.rgba(), slicesHeight,
+                                     devicePixelRatio);
+    auto it = m_titlebarSlices.constFind(key);
+    if (it == m_titlebarSlices.constEnd()) {
+        it = m_titlebarSlices.insert(
+                key,
+                renderTitlebarSlices(backgroundColor, borderColor,
+                                     titlebarCornerMask(false, devicePixelRatio),
+                                     titlebarCornerMask(true, devicePixelRatio), slicesHeight,
+                                     devicePixelRatio));
+    }
+    drawTitlebarSlices(painter,
+                       QRect(shadowMargins.left(), shadowMargins.top() - 1, titleBarWidth + 1,
+                             slicesHeight),
+                       it.value());
+
+    if (fractionalScale) {
+        painter->save();
+        painter->setPen(borderColor);
+        painter->drawRect(QRectF(topLeft.x(), margins.top(), titleBarWidth, borderRectHeight));
+        painter->restore();
+    } else {
+        paintRoundedWindowBorder(painter, geometry, borderColor, devicePixelRatio);
+    }
+
+    painter->setRenderHint(QPainter::Antialiasing, antialiasing);
+}
+
+// Same pixels as stroking the border, a one pixel wide line centered on the edges
+// of the content, but in whole device pixels without the rasterizer
+void QAdwaitaDecorationRenderer::paintRoundedWindowBorder(QPainter *painter,
+                                                          const Geometry &geometry,
+                                                          const QColor &borderColor,
+                                                          qreal devicePixelRatio)
+{
+    const QRect &surfaceRect = geometry.surfaceRect;
+    const QMargins &margins = geometry.margins;
+    const QMargins &shadowMargins = geometry.shadowMargins;
+
+    const int left = shadowMargins.left();
+    const int width = surfaceRect.width() - shadowMargins.left() - shadowMargins.right();
+    const int right = left + width - 1;
+    const int top = margins.top();
+    const int bottom = surfaceRect.height() - margins.bottom();
+
+    // Top half of the line falls into the last titlebar row, odd scales leave a
+    // half covered row of device pixels
+    const int scale = static_cast<int>(devicePixelRatio);
+    const qreal rowHeight = 1.0 / devicePixelRatio;
+    const int fullRows = scale / 2;
+    if (fullRows > 0) {
+        painter->fillRect(QRectF(left, top - fullRows * rowHeight, width, fullRows * rowHeight),
+                          borderColor);
+    }
+    if (scale % 2) {
+        QColor halfCoveredColor = borderColor;
+        halfCoveredColor.setAlphaF(borderColor.alphaF() / 2);
+        painter->fillRect(QRectF(left, top - (fullRows + 1) * rowHeight, width, rowHeight),
+                          halfCoveredColor);
+    }
+
+    painter->fillRect(QRect(left, top, 1, bottom - top), borderColor);
+    painter->fillRect(QRect(right, top, 1, bottom - top), borderColor);
+
+    // Bottom half of the line is below the content, with corners cut by the line join
+    const auto key = std::make_pair(borderColor.rgba(), devicePixelRatio);
+    auto it = m_borderBottomSlices.constFind(key);
+    if (it == m_borderBottomSlices.constEnd()) {
+        it = m_borderBottomSlices.insert(key,
+                                         renderBorderBottomSlices(borderColor, devicePixelRatio));
+    }
+    drawTitlebarSlices(painter, QRect(left, bottom, width, 1), it.value());
+}
+
+void QAdwaitaDecorationRenderer::paintTitle(QPainter *painter, const State &state,
+                                            const Geometry &geometry,
+                                            const QColor &foregroundColor)
+{
+    const QRect &top = geometry.titleBarRect;
+    const QRect &titleRect = geometry.titleRect;
+    if (state.title.isEmpty() || titleRect.width() <= 0)
+        return;
+
+    const QStaticText &windowTitle = titleLayout(state.title, state.font, titleRect.width(),
+                                                 painter->device()->devicePixelRatioF());
+
+    // Centered in the titlebar, unless it would overlap the buttons. Elided
+    // title always fits, no need to clip it.
+    const QSize size = windowTitle.size().toSize();
+    int x = top.left() + (top.width() - size.width()) / 2;
+    x = qMin(x, titleRect.left() + titleRect.width() - size.width());
+    x = qMax(x, titleRect.left());
+    const int y = top.top() + (top.height() - size.height()) / 2;
+
+    if (size.width() <= titleRect.width()) {
+        painter->setPen(foregroundColor);
+        painter->setFont(state.font);
+        painter->drawStaticText(QPoint(x, y), windowTitle);
+    }
+}
+
+void QAdwaitaDecorationRenderer::updateShadowPixmap(const QColor &color, qreal devicePixelRatio)
+{
+    if (!m_shadowPixmap.isNull() && m_shadowColor == color
+        && m_shadowPixmap.devicePixelRatio() == devicePixelRatio) {
+        return;
+    }
+
+    const QPixmap shadowTiles = m_layerCache->shadowTiles(color, devicePixelRatio);
+    if (!shadowTiles.isNull()) {
+        m_shadowPixmap = shadowTiles;
+        m_shadowColor = color;
+        m_shadowPending = false;
+        return;
+    }
+
+    // Keep the current shadow until the new one is rendered, a new window borrows
+    // one rendered for another window
+    m_shadowPending = true;
+    m_pendingShadow = std::make_pair(color.rgba(), devicePixelRatio);
+    if (m_shadowPixmap.isNull())
+        m_shadowPixmap = m_layerCache->placeholderShadowTiles(color);
+}
+
+void QAdwaitaDecorationRenderer::shadowTilesRendered(QRgb color, qreal devicePixelRatio)
+{
+    // Another shadow was requested in the meantime, or it's not this renderer's
+    if (!m_shadowPending || m_pendingShadow != std::make_pair(color, devicePixelRatio))
+        return;
+
+    m_shadowPending = false;
+    m_shadowPixmap = m_layerCache->shadowTiles(QColor::fromRgba(color), devicePixelRatio);
+    m_shadowColor = QColor::fromRgba(color);
+    Q_EMIT shadowRendered();
+}
+
+static void renderFlatRoundedButtonFrame(QPainter *painter, const QRect &rect, const QColor &color)
+{
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(color);
+    painter->drawEllipse(rect);
+    painter->restore();
+}
+
+static void renderButtonIcon(QAdwaitaDecorationRenderer::ButtonIcon buttonIcon,
+                             QPainter *painter, const QRect &rect)
+{
+    QString iconName = buttonMap[buttonIcon];
+
+    painter->save();
+    painter->setRenderHints(QPainter::Antialiasing, true);
+    painter->drawPixmap(rect, QIcon::fromTheme(iconName).pixmap(ceButtonWidth, ceButtonWidth));
+
+    painter->restore();
+}
+
+static QAdwaitaDecorationRenderer::ButtonIcon
+iconFromButtonAndState(QAdwaitaDecorationRenderer::Button button, bool maximized)
+{
+    if (button == QAdwaitaDecorationRenderer::Close)
+        return QAdwaitaDecorationRenderer::CloseIcon;
+    else if (button == QAdwaitaDecorationRenderer::Minimize)
+        return QAdwaitaDecorationRenderer::MinimizeIcon;
+    else if (button == QAdwaitaDecorationRenderer::Maximize && maximized)
+        return QAdwaitaDecorationRenderer::RestoreIcon;
+    else
+        return QAdwaitaDecorationRenderer::MaximizeIcon;
+}
+
+void QAdwaitaDecorationRenderer::paintButton(QPainter *painter, const State &state,
+                                             const Geometry &geometry, Button button)
+{
+    QColor activeBackgroundColor;
+    if (state.pressedButton == button)
+        activeBackgroundColor = state.colors.value(PressedButtonBackground);
+    else if (state.hoveredButtons.testFlag(button))
+        activeBackgroundColor = state.colors.value(HoveredButtonBackground);
+    else
+        activeBackgroundColor = state.colors.value(ButtonBackground);
+
+    const QColor buttonBackgroundColor =
+            state.active ? activeBackgroundColor : state.colors.value(ButtonBackgroundInactive);
+    const QColor foregroundColor =
+            state.colors.value(state.active ? Foreground : ForegroundInactive);
+
+    const QRect btnRect = geometry.buttonRects.value(button).toRect();
+    painter->drawPixmap(btnRect.topLeft(),
+                        buttonPixmap(iconFromButtonAndState(button, state.maximized),
+                                     buttonBackgroundColor, foregroundColor,
+                                     painter->device()->devicePixelRatioF()));
+}
+
+QPixmap QAdwaitaDecorationRenderer::buttonPixmap(ButtonIcon buttonIcon,
+                                                 const QColor &backgroundColor,
+                                                 const QColor &foregroundColor,
+                                                 qreal devicePixelRatio)
+{
+    const auto key = std::make_tuple(buttonIcon, backgroundColor.rgba(), foregroundColor.rgba(),
+                                     devicePixelRatio);
+    auto it = m_buttonPixmaps.constFind(key);
+    if (it != m_buttonPixmaps.constEnd())
+        return it.value();
+
+    const QRect rect(0, 0, ceButtonWidth, ceButtonWidth);
+    QPixmap pixmap(rect.size() * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    const QPixmap icon = buttonIconPixmap(buttonIcon, foregroundColor, devicePixelRatio);
+
+    QPainter painter(&pixmap);
+    renderFlatRoundedButtonFrame(&painter, rect, backgroundColor);
+    if (!icon.isNull())
+        painter.drawPixmap(QPoint(4, 4), icon);
+    painter.end();
+
+    // Keep only complete buttons, the icon might be still loading or rendering
+    if (!icon.isNull()
+        && !m_pendingIconMasks.contains(std::make_pair(buttonIcon, devicePixelRatio))) {
+        m_buttonPixmaps.insert(key, pixmap);
+    }
+    return pixmap;
+}
+
+QPixmap QAdwaitaDecorationRenderer::buttonIconPixmap(ButtonIcon buttonIcon, const QColor &color,
+                                                     qreal devicePixelRatio)
+{
+    const auto key = std::make_tuple(buttonIcon, color.rgba(), devicePixelRatio);
+    auto it = m_iconPixmaps.constFind(key);
+    if (it != m_iconPixmaps.constEnd())
+        return it.value();
+
+    const QImage mask = buttonIconMask(buttonIcon, devicePixelRatio);
+
+    // Paint only the button frame until the icon is loaded
+    if (mask.isNull() && !m_icons.contains(buttonIcon)) {
+        Q_EMIT iconsRequested();
+        return QPixmap();
+    }
+
+    const QRect rect(0, 0, ceIconSize, ceIconSize);
+
+    // Scale the icon rendered for another device pixel ratio until this one is ready,
+    // it's not cached
+    if (m_pendingIconMasks.contains(std::make_pair(buttonIcon, devicePixelRatio)))
+        return QPixmap::fromImage(colorizedMask(placeholderIconMask(buttonIcon), color));
+
+    QPixmap pixmap;
+    if (!mask.isNull()) {
+        // Symbolic icons are single colored, paint the whole shape with the color
+        pixmap = QPixmap::fromImage(colorizedMask(mask, color));
+    } else {
+        pixmap = QPixmap(rect.size() * devicePixelRatio);
+        pixmap.setDevicePixelRatio(devicePixelRatio);
+        pixmap.fill(Qt::transparent);
+
+        // Fallback to use QIcon
+        QPainter painter(&pixmap);
+        renderButtonIcon(buttonIcon, &painter, rect);
+        painter.end();
+    }
+
+    m_iconPixmaps.insert(key, pixmap);
+    return pixmap;
+}
+
+const QStaticText &QAdwaitaDecorationRenderer::titleLayout(const QString &title,
+                                                           const QFont &font, int width,
+                                                           qreal devicePixelRatio)
+{
+    TitleLayout &layout = m_titleLayout;
+    if (layout.title == title && layout.font == font && layout.width == width
+        && layout.devicePixelRatio == devicePixelRatio) {
+        return layout.text;
+    }
+
+    layout.title = title;
+    layout.font = font;
+    layout.width = width;
+    layout.devicePixelRatio = devicePixelRatio;
+
+    // Long titles are elided instead of being cut by the buttons
+    const QFontMetrics metrics(font);
+    layout.text.setText(metrics.elidedText(title, Qt::ElideRight, width));
+    layout.text.prepare(QTransform(), font);
+    return layout.text;
+}
+
+QImage QAdwaitaDecorationRenderer::titlebarCornerMask(bool border, qreal devicePixelRatio)
+{
+    const auto key = std::make_pair(border, devicePixelRatio);
+    auto it = m_titlebarCornerMasks.constFind(key);
+    if (it == m_titlebarCornerMasks.constEnd()) {
+        it = m_titlebarCornerMasks.insert(
+                key, QAdwaitaAssets::renderTitlebarCornerMask(border, devicePixelRatio));
+    }
+    return it.value();
+}
+
+QImage QAdwaitaDecorationRenderer::buttonIconMask(ButtonIcon buttonIcon, qreal devicePixelRatio)
+{
+    if (m_useBakedIcons) {
+        const QImage mask =
+                QAdwaitaAssets::bakedIconMask(buttonMap.value(buttonIcon), devicePixelRatio);
+        if (!mask.isNull())
+            return mask;
+    }
+
+    const std::shared_ptr<QSvgRenderer> renderer = m_iconRenderers.value(buttonIcon);
+    if (!renderer)
+        return QImage();
+
+    const QImage mask =
+            m_layerCache->iconMask(m_icons.value(buttonIcon), renderer.get(), devicePixelRatio);
+    const auto key = std::make_pair(buttonIcon, devicePixelRatio);
+    if (mask.isNull() && !m_pendingIconMasks.contains(key))
+        m_pendingIconMasks.append(key);
+    return mask;
+}
+
+QImage QAdwaitaDecorationRenderer::placeholderIconMask(ButtonIcon buttonIcon) const
+{
+    return m_layerCache->placeholderIconMask(m_icons.value(buttonIcon));
+}
+
+void QAdwaitaDecorationRenderer::iconMaskRendered(const QByteArray &svgIcon,
+                                                  qreal devicePixelRatio)
+{
+    // Icons were reloaded in the meantime, or they are not this renderer's
+    bool rendered = false;
+    for (auto it = m_icons.constBegin(); it != m_icons.constEnd(); ++it) {
+        if (it.value() == svgIcon)
+            rendered |= m_pendingIconMasks.removeOne(std::make_pair(it.key(), devicePixelRatio));
+    }
+
+    if (rendered)
+        Q_EMIT buttonIconsRendered();
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_DECORATION_RENDERER_H
+#define QADWAITA_DECORATION_RENDERER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtGui/QColor>
+#include <QtGui/QFont>
+#include <QtGui/QImage>
+#include <QtGui/QPixmap>
+#include <QtGui/QRegion>
+#include <QtGui/QStaticText>
+
+#include <memory>
+#include <tuple>
+#include <utility>
+
+class QAdwaitaLayerCache;
+class QPainter;
+class QSvgRenderer;
+
+// Paints the decorations of a window described by a plain state into any paint
+// device. It doesn't know about Wayland or the window, so it can be used offscreen.
+// Rendered layers are cached between paints. Slow ones are shared by all renderers
+// in the process, rendered in a worker thread and announced once they are ready.
+class QAdwaitaDecorationRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    enum ColorType {
+        Background,
+        BackgroundInactive,
+        Foreground,
+        ForegroundInactive,
+        Border,
+        BorderInactive,
+        ButtonBackground,
+        ButtonBackgroundInactive,
+        HoveredButtonBackground,
+        PressedButtonBackground
+    };
+    enum Placement { Left = 0, Right = 1 };
+    enum Button { None = 0x0, Close = 0x1, Minimize = 0x02, Maximize = 0x04 };
+    Q_DECLARE_FLAGS(Buttons, Button);
+    enum ButtonIcon { CloseIcon, MinimizeIcon, MaximizeIcon, RestoreIcon };
+
+    // Everything what the decoration looks like depends on
+    struct State
+    {
+        // Whole surface including shadows
+        QSize size;
+        bool active = false;
+        bool maximized = false;
+        Qt::Edges tiledEdges;
+        // Window content has an alpha channel
+        bool translucent = false;
+        QString title;
+        QMap<ColorType, QColor> colors;
+        QFont font;
+        Placement placement = Right;
+        // Buttons by their position from the window edge, starting with 1
+        QMap<Button, uint> buttons;
+        Buttons hoveredButtons = None;
+        Button pressedButton = None;
+    };
+
+    // Layout of the decoration in surface coordinates
+    struct Geometry
+    {
+        QMargins margins;
+        QMargins shadowMargins;
+        QRect surfaceRect;
+        QRect titleBarRect;
+        QRect titleRect;
+        QMap<Button, QRectF> buttonRects;
+        // Everything but shadows, rounded corners and translucent content
+        QRegion opaqueRegion;
+    };
+
+    explicit QAdwaitaDecorationRenderer(bool useBakedIcons, QObject *parent = nullptr);
+
+    static QMargins margins(bool maximized, Qt::Edges tiledEdges);
+    // Part of margins() taken by shadows
+    static QMargins shadowMargins(bool maximized, Qt::Edges tiledEdges);
+    static Geometry geometry(const State &state);
+    static QMap<ColorType, QColor> colors(bool useDarkColors);
+
+    // Names of the themed icons used for buttons, set with setIcons() once loaded
+    static QStringList iconNames();
+    void setIcons(const QHash<QString, QByteArray> &icons);
+
+    // Everything but the window content, which is left untouched
+    void paint(QPainter *painter, const State &state, const Geometry &geometry);
+
+Q_SIGNALS:
+    // An icon which wasn't set yet is needed
+    void iconsRequested();
+    // Layers rendered in a worker thread are ready to be painted
+    void shadowRendered();
+    void buttonIconsRendered();
+
+private:
+    void paintSquareTitlebar(QPainter *painter, const Geometry &geometry,
+                             const QColor &backgroundColor, const QColor &borderColor);
+    void paintRoundedTitlebar(QPainter *painter, const Geometry &geometry,
+                              const QColor &backgroundColor, const QColor &borderColor,
+                              bool active);
+    void paintRoundedWindowBorder(QPainter *painter, const Geometry &geometry,
+                                  const QColor &borderColor, qreal devicePixelRatio);
+    void paintTitle(QPainter *painter, const State &state, const Geometry &geometry,
+                    const QColor &foregroundColor);
+    void paintButton(QPainter *painter, const State &state, const Geometry &geometry,
+                     Button button);
+
+    void updateShadowPixmap(const QColor &color, qreal devicePixelRatio);
+    void shadowTilesRendered(QRgb color, qreal devicePixelRatio);
+    QPixmap buttonPixmap(ButtonIcon buttonIcon, const QColor &backgroundColor,
+                         const QColor &foregroundColor, qreal devicePixelRatio);
+    QPixmap buttonIconPixmap(ButtonIcon buttonIcon, const QColor &color, qreal devicePixelRatio);
+    QImage buttonIconMask(ButtonIcon buttonIcon, qreal devicePixelRatio);
+    QImage placeholderIconMask(ButtonIcon buttonIcon) const;
+    void iconMaskRendered(const QByteArray &svgIcon, qreal devicePixelRatio);
+    QImage titlebarCornerMask(bool border, qreal devicePixelRatio);
+    const QStaticText &titleLayout(const QString &title, const QFont &font, int width,
+                                   qreal devicePixelRatio);
+
+    // Window title elided to fit, laid out again only when any of the inputs change
+    struct TitleLayout
+    {
+        QString title;
+        QFont font;
+        int width = -1;
+        qreal devicePixelRatio = 0;
+        QStaticText text;
+    };
+    TitleLayout m_titleLayout;
+
+    // Shadows and icon masks shared with other renderers
+    std::shared_ptr<QAdwaitaLayerCache> m_layerCache;
+    // Colors the cached layers were rendered with
+    QMap<ColorType, QColor> m_colors;
+    QPixmap m_shadowPixmap;
+    QColor m_shadowColor;
+    // Shadow being rendered in a worker thread, the current one is used until it's ready
+    bool m_shadowPending = false;
+    std::pair<QRgb, qreal> m_pendingShadow;
+    // Titlebar outlines by background, border, height and device pixel ratio
+    QMap<std::tuple<QRgb, QRgb, int, qreal>, QPixmap> m_titlebarSlices;
+    // Bottom edge of the window border by color and device pixel ratio
+    QMap<std::pair<QRgb, qreal>, QPixmap> m_borderBottomSlices;
+    // Titlebar corner coverage by background/border and device pixel ratio
+    QMap<std::pair<bool, qreal>, QImage> m_titlebarCornerMasks;
+    bool m_useBakedIcons = false;
+    QMap<ButtonIcon, QByteArray> m_icons;
+    QMap<ButtonIcon, std::shared_ptr<QSvgRenderer>> m_iconRenderers;
+    // Icon masks being rendered in a worker thread, placeholders are used until they are ready
+    QList<std::pair<ButtonIcon, qreal>> m_pendingIconMasks;
+    // Rendered icons by icon, foreground color and device pixel ratio
+    QMap<std::tuple<ButtonIcon, QRgb, qreal>, QPixmap> m_iconPixmaps;
+    // Button frames with icons by icon, background and foreground color and device pixel ratio
+    QMap<std::tuple<ButtonIcon, QRgb, QRgb, qreal>, QPixmap> m_buttonPixmaps;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QAdwaitaDecorationRenderer::Buttons)
+
+#endif // QADWAITA_DECORATION_RENDERER_H
@@ -18,23 +18,28 @@
  */
 
 #include "qadwaitadecorations.h"
+#include "qadwaitaassets.h"
+#include "qadwaitadecorationsurface.h"
+#include "qadwaitaiconstore.h"
+#include "qadwaitalogging.h"
 
+#include <QtWaylandClient/private/qwaylanddisplay_p.h>
+#include <QtWaylandClient/private/qwaylandinputdevice_p.h>
 #include <QtWaylandClient/private/qwaylandshellsurface_p.h>
 #include <QtWaylandClient/private/qwaylandshmbackingstore_p.h>
 #include <QtWaylandClient/private/qwaylandwindow_p.h>
 
-#include <QtCore/QLoggingCategory>
-#include <QScopeGuard>
+#include <wayland-client-protocol.h>
+
+#include <QtCore/QtMath>
 
 #include <QtGui/QColor>
 #include <QtGui/QPainter>
-#include <QtGui/QPainterPath>
+#include <QtGui/QScreen>
 
 #include <QtGui/private/qguiapplication_p.h>
 #include <QtGui/qpa/qplatformtheme.h>
 
-#include <QtSvg/QSvgRenderer>
-
 // QtDBus
 #include <QtDBus/QDBusArgument>
 #include <QtDBus/QDBusConnection>
@@ -45,24 +50,10 @@
 #include <QtDBus/QDBusVariant>
 #include <QtDBus/QtDBus>
 
-static constexpr int ceButtonSpacing = 12;
-static constexpr int ceButtonWidth = 24;
-static constexpr int ceCornerRadius = 12;
-static constexpr int ceShadowsWidth = 10;
-static constexpr int ceTitlebarHeight = 38;
-static constexpr int ceWindowBorderWidth = 1;
-
-static QMap<QAdwaitaDecorations::ButtonIcon, QString> buttonMap = {
-    { QAdwaitaDecorations::CloseIcon, QStringLiteral("window-close-symbolic") },
-    { QAdwaitaDecorations::MinimizeIcon, QStringLiteral("window-minimize-symbolic") },
-    { QAdwaitaDecorations::MaximizeIcon, QStringLiteral("window-maximize-symbolic") },
-    { QAdwaitaDecorations::RestoreIcon, QStringLiteral("window-restore-symbolic") }
-};
-
-Q_DECL_IMPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality,
-                                bool alphaOnly, int transposed = 0);
-
-Q_LOGGING_CATEGORY(QAdwaitaDecorationsLog, "qt.qpa.qadwaitadecorations", QtWarningMsg)
+// Milliseconds to wait for a frame callback before repainting anyway
+static constexpr int ceFrameCallbackTimeout = 100;
+// Part of the shadow outside of the window border used for resizing
+static constexpr int ceResizeBandWidth = 8;
 
 const QDBusArgument &operator>>(const QDBusArgument &argument, QMap<QString, QVariantMap> &map)
 {
@@ -82,6 +73,16 @@ const QDBusArgument &operator>>(const QDBusArgument &argument, QMap<QString, QVa
     return argument;
 }
 
+static int resizeBandWidth()
+{
+    static const int width = [] {
+        bool ok = false;
+        const int width = qEnvironmentVariableIntValue("QADWAITA_RESIZE_BAND", &ok);
+        return ok ? qBound(0, width, ceShadowsWidth) : ceResizeBandWidth;
+    }();
+    return width;
+}
+
 QAdwaitaDecorations::QAdwaitaDecorations()
 {
 #ifdef HAS_QT6_SUPPORT
@@ -95,11 +96,26 @@ QAdwaitaDecorations::QAdwaitaDecorations()
 #endif
 
     m_lastButtonClick = QDateTime::currentDateTime();
-
-    QTextOption option(Qt::AlignHCenter | Qt::AlignVCenter);
-    option.setWrapMode(QTextOption::NoWrap);
-    m_windowTitle.setTextOption(option);
-    m_windowTitle.setTextFormat(Qt::PlainText);
+    m_iconStore = QAdwaitaIconStore::instance();
+    connect(m_iconStore.get(), &QAdwaitaIconStore::iconsChanged, this,
+            &QAdwaitaDecorations::updateIcons);
+
+    // Default icons are baked into the plugin
+    const QString iconThemeName = QIcon::themeName();
+    m_useBakedIcons = iconThemeName.isEmpty() || iconThemeName == QLatin1String("Adwaita");
+
+    m_renderer = std::make_unique<QAdwaitaDecorationRenderer>(m_useBakedIcons);
+    connect(m_renderer.get(), &QAdwaitaDecorationRenderer::iconsRequested, this,
+            &QAdwaitaDecorations::loadIcons);
+    connect(m_renderer.get(), &QAdwaitaDecorationRenderer::shadowRendered, this, [this]() {
+        const Geometry &geometry = decorationGeometry();
+        const QRect surfaceRect(QPoint(), geometry.surfaceRect.size());
+        repaintRegion(
+                QRegion(surfaceRect).subtracted(surfaceRect.marginsRemoved(geometry.margins)));
+    });
+    connect(m_renderer.get(), &QAdwaitaDecorationRenderer::buttonIconsRendered, this, [this]() {
+        repaintRegion(buttonsRegion(Buttons(Button::Close) | Button::Maximize | Button::Minimize));
+    });
 
     const QPlatformTheme *theme = QGuiApplicationPrivate::platformTheme();
     if (const QFont *font = theme->font(QPlatformTheme::TitleBarFont))
@@ -107,9 +123,19 @@ QAdwaitaDecorations::QAdwaitaDecorations()
     if (!m_font)
         m_font = std::make_unique<QFont>(QLatin1String("Sans"), 10);
 
+    m_repaintTimer.setSingleShot(true);
+    connect(&m_repaintTimer, &QTimer::timeout, this, &QAdwaitaDecorations::performRepaint);
+    m_motionTimer.setSingleShot(true);
+    connect(&m_motionTimer, &QTimer::timeout, this, &QAdwaitaDecorations::processPendingMotion);
+
     QTimer::singleShot(0, this, &QAdwaitaDecorations::initConfiguration);
 }
 
+QAdwaitaDecorations::~QAdwaitaDecorations()
+{
+    cancelFrameCallback();
+}
+
 void QAdwaitaDecorations::initConfiguration()
 {
     qRegisterMetaType<QDBusVariant>();
@@ -155,18 +181,27 @@ void QAdwaitaDecorations::initConfiguration()
                                         .toString();
                         if (titlebarFont.contains(QLatin1String("bold"), Qt::CaseInsensitive)) {
                             m_font->setBold(true);
+                            updateVisualState();
                         }
                     }
                 }
                 watcher->deleteLater();
             });
 
+    // Title is repainted on its own, paced with the rest of the repaints
+    connect(window(), &QWindow::windowTitleChanged, this,
+            &QAdwaitaDecorations::updateVisualState);
+
     QDBusConnection::sessionBus().connect(
             QString(), QLatin1String("/org/freedesktop/portal/desktop"),
             QLatin1String("org.freedesktop.portal.Settings"), QLatin1String("SettingChanged"), this,
             SLOT(settingChanged(QString, QString, QDBusVariant)));
 
     updateColors(false);
+
+    // Icons are loaded in the background, use what is available already
+    if (!m_useBakedIcons)
+        loadIcons();
     updateIcons();
 }
 
@@ -175,63 +210,19 @@ void QAdwaitaDecorations::updateColors(bool useDarkColors)
     qCDebug(QAdwaitaDecorationsLog)
             << "Changing color scheme to " << (useDarkColors ? "dark" : "light");
 
-    m_colors = { { Background, useDarkColors ? QColor(0x303030) : QColor(0xffffff) },
-                 { BackgroundInactive, useDarkColors ? QColor(0x242424) : QColor(0xfafafa) },
-                 { Foreground, useDarkColors ? QColor(0xffffff) : QColor(0x2e2e2e) },
-                 { ForegroundInactive, useDarkColors ? QColor(0x919191) : QColor(0x949494) },
-                 { Border, useDarkColors ? QColor(0x3b3b3b) : QColor(0xdbdbdb) },
-                 { BorderInactive, useDarkColors ? QColor(0x303030) : QColor(0xdbdbdb) },
-                 { ButtonBackground, useDarkColors ? QColor(0x444444) : QColor(0xebebeb) },
-                 { ButtonBackgroundInactive, useDarkColors ? QColor(0x2e2e2e) : QColor(0xf0f0f0) },
-                 { HoveredButtonBackground, useDarkColors ? QColor(0x4f4f4f) : QColor(0xe0e0e0) },
-                 { PressedButtonBackground, useDarkColors ? QColor(0x6e6e6e) : QColor(0xc2c2c2) } };
-    forceRepaint();
+    m_colors = QAdwaitaDecorationRenderer::colors(useDarkColors);
+    updateVisualState();
 }
 
-QString getIconSvg(const QString &iconName)
+void QAdwaitaDecorations::updateIcons()
 {
-    const QStringList themeNames = { QIcon::themeName(), QIcon::fallbackThemeName(),
-                                     QLatin1String("Adwaita") };
-    qCDebug(QAdwaitaDecorationsLog) << "Icon themes: " << themeNames;
-
-    for (const QString &themeName : themeNames) {
-        for (const QString &path : QIcon::themeSearchPaths()) {
-            if (path.startsWith(QLatin1Char(':')))
-                continue;
-
-            const QString fullPath = QString("%1/%2").arg(path).arg(themeName);
-            QDirIterator dirIt(fullPath, QDirIterator::Subdirectories);
-            while (dirIt.hasNext()) {
-                const QString fileName = dirIt.next();
-                const QFileInfo fileInfo(fileName);
-
-                if (fileInfo.isDir())
-                    continue;
-
-                if (fileInfo.fileName() == iconName) {
-                    qCDebug(QAdwaitaDecorationsLog)
-                            << "Using " << iconName << " from " << themeName << " theme";
-                    QFile readFile(fileInfo.filePath());
-                    readFile.open(QFile::ReadOnly);
-                    return readFile.readAll();
-                }
-            }
-        }
-    }
-
-    qCWarning(QAdwaitaDecorationsLog) << "Failed to find an svg icon for " << iconName;
-
-    return QString();
+    m_renderer->setIcons(m_iconStore->icons());
+    forceRepaint();
 }
 
-void QAdwaitaDecorations::updateIcons()
+void QAdwaitaDecorations::loadIcons()
 {
-    for (auto mapIt = buttonMap.constBegin(); mapIt != buttonMap.constEnd(); mapIt++) {
-        const QString fullName = mapIt.value() + QStringLiteral(".svg");
-        m_icons[mapIt.key()] = getIconSvg(fullName);
-    }
-
-    forceRepaint();
+    m_iconStore->load(QAdwaitaDecorationRenderer::iconNames());
 }
 
 void QAdwaitaDecorations::updateTitlebarLayout(const QString &layout)
@@ -248,28 +239,31 @@ void QAdwaitaDecorations::updateTitlebarLayout(const QString &layout)
 
     const QString &leftLayout = layouts.at(0);
     const QString &rightLayout = layouts.at(1);
-    m_placement = leftLayout.contains(QLatin1String("close")) ? Left : Right;
+    m_placement = leftLayout.contains(QLatin1String("close")) ? QAdwaitaDecorationRenderer::Left
+                                                              : QAdwaitaDecorationRenderer::Right;
 
     int pos = 1;
-    const QString &buttonLayout = m_placement == Right ? rightLayout : leftLayout;
+    const QString &buttonLayout =
+            m_placement == QAdwaitaDecorationRenderer::Right ? rightLayout : leftLayout;
 
     QStringList buttonList = buttonLayout.split(QLatin1Char(','));
-    if (m_placement == Right) {
+    if (m_placement == QAdwaitaDecorationRenderer::Right) {
         std::reverse(buttonList.begin(), buttonList.end());
     }
 
     for (const QString &button : buttonList) {
         if (button == QLatin1String("close")) {
-            m_buttons.insert(Close, pos);
+            m_buttons.insert(Button::Close, pos);
         } else if (button == QLatin1String("maximize")) {
-            m_buttons.insert(Maximize, pos);
+            m_buttons.insert(Button::Maximize, pos);
         } else {
-            m_buttons.insert(Minimize, pos);
+            m_buttons.insert(Button::Minimize, pos);
         }
         pos++;
     }
 
-    forceRepaint();
+    m_geometry.valid = false;
+    updateVisualState();
 }
 
 void QAdwaitaDecorations::settingChanged(const QString &group, const QString &key,
@@ -288,354 +282,236 @@ void QAdwaitaDecorations::settingChanged(const QString &group, const QString &ke
 
 QRectF QAdwaitaDecorations::buttonRect(Button button) const
 {
-    int xPos;
-    int yPos;
-    const int btnPos = m_buttons.value(button);
+    return decorationGeometry().buttonRects.value(button);
+}
 
-    if (m_placement == Right) {
-        xPos = windowContentGeometry().width();
-        xPos -= ceButtonWidth * btnPos;
-        xPos -= ceButtonSpacing * btnPos;
-#ifdef HAS_QT6_SUPPORT
-        xPos -= margins(ShadowsOnly).right();
-#endif
-    } else {
-        xPos = 0;
-        xPos += ceButtonWidth * btnPos;
-        xPos += ceButtonSpacing * btnPos;
+const QAdwaitaDecorations::Geometry &QAdwaitaDecorations::decorationGeometry() const
+{
 #ifdef HAS_QT6_SUPPORT
-        xPos += margins(ShadowsOnly).left();
+    const bool maximized = waylandWindow()->windowStates() & Qt::WindowMaximized;
+#else
+    const bool maximized = window()->windowStates() & Qt::WindowMaximized;
 #endif
-        // We are painting from the left to the right so the real
-        // position doesn't need to by moved by the size of the button.
-        xPos -= ceButtonWidth;
+    const Qt::Edges edges = tiledEdges();
+    // Everything else is derived from the window size and states
+    const QSize size = waylandWindow()->geometry().size();
+    if (m_geometry.valid && m_geometry.size == size && m_geometry.maximized == maximized
+        && m_geometry.tiledEdges == edges) {
+        return m_geometry;
+    }
+
+    Geometry geometry;
+    static_cast<QAdwaitaDecorationRenderer::Geometry &>(geometry) =
+            QAdwaitaDecorationRenderer::geometry(currentVisualState());
+    geometry.valid = true;
+    geometry.size = size;
+    geometry.maximized = maximized;
+    geometry.tiledEdges = edges;
+
+    const QMargins &m = geometry.margins;
+    const QMargins &shadows = geometry.shadowMargins;
+    geometry.leftEdge = geometry.surfaceRect.left() + m.left();
+    geometry.rightEdge = geometry.surfaceRect.right() - m.right();
+    geometry.topEdge = geometry.surfaceRect.top() + m.bottom();
+    geometry.titleBottom = geometry.surfaceRect.top() + m.top();
+    geometry.bottomEdge = geometry.surfaceRect.bottom() - m.bottom();
+    for (const Button button : { Button::Close, Button::Maximize, Button::Minimize }) {
+        if (m_buttons.contains(button))
+            geometry.buttonZones.append({ button, geometry.buttonRects.value(button) });
     }
 
-    yPos = margins().top();
-    yPos += margins().bottom();
-    yPos -= ceButtonWidth;
-    yPos /= 2;
+    // Shadows don't take input except for the resize band around the border
+    const QRect frameRect = geometry.surfaceRect.marginsRemoved(shadows);
+    const int band = resizeBandWidth();
+    geometry.inputRegion = frameRect.marginsAdded(
+            QMargins(qMin(band, shadows.left()), qMin(band, shadows.top()),
+                     qMin(band, shadows.right()), qMin(band, shadows.bottom())));
 
-    return QRectF(xPos, yPos, ceButtonWidth, ceButtonWidth);
+    m_geometry = geometry;
+    return m_geometry;
 }
 
 #ifdef HAS_QT6_SUPPORT
 QMargins QAdwaitaDecorations::margins(MarginsType marginsType) const
 {
-    const bool onlyShadows = marginsType == ShadowsOnly;
-    const bool shadowsExcluded = marginsType == ShadowsExcluded;
+    const bool maximized = waylandWindow()->windowStates() & Qt::WindowMaximized;
+    const Qt::Edges edges = tiledEdges();
 
-    if (waylandWindow()->windowStates() & Qt::WindowMaximized) {
-        // Maximized windows don't have anything around, no shadows, border,
-        // etc. Only report titlebar height in case we are not asking for shadow
-        // margins.
-        return QMargins(0, onlyShadows ? 0 : ceTitlebarHeight, 0, 0);
-    }
+    const QMargins shadowMargins = QAdwaitaDecorationRenderer::shadowMargins(maximized, edges);
+    if (marginsType == ShadowsOnly)
+        return shadowMargins;
 
-    const QWaylandWindow::ToplevelWindowTilingStates tilingStates =
-            waylandWindow()->toplevelWindowTilingStates();
-
-    // Since all sides (left, right, bottom) are going to be same
-    const int marginsBase =
-            shadowsExcluded ? ceWindowBorderWidth : ceShadowsWidth + ceWindowBorderWidth;
-    const int sideMargins = onlyShadows ? ceShadowsWidth : marginsBase;
-    const int topMargins = onlyShadows ? ceShadowsWidth : ceTitlebarHeight + marginsBase;
-
-    return QMargins(tilingStates & QWaylandWindow::WindowTiledLeft ? 0 : sideMargins,
-                    tilingStates & QWaylandWindow::WindowTiledTop
-                            ? onlyShadows ? 0 : ceTitlebarHeight
-                            : topMargins,
-                    tilingStates & QWaylandWindow::WindowTiledRight ? 0 : sideMargins,
-                    tilingStates & QWaylandWindow::WindowTiledBottom ? 0 : sideMargins);
+    const QMargins margins = QAdwaitaDecorationRenderer::margins(maximized, edges);
+    return marginsType == ShadowsExcluded ? margins - shadowMargins : margins;
 }
 #else
 QMargins QAdwaitaDecorations::margins() const
 {
-    if (window()->windowStates() & Qt::WindowMaximized) {
-        // Maximized windows don't have anything around, no shadows, border,
-        // etc. Only report titlebar height.
-        return QMargins(0, ceTitlebarHeight, 0, 0);
-    }
-
-    return QMargins(ceWindowBorderWidth, ceWindowBorderWidth + ceTitlebarHeight,
-                    ceWindowBorderWidth, ceWindowBorderWidth);
+    return QAdwaitaDecorationRenderer::margins(window()->windowStates() & Qt::WindowMaximized,
+                                               Qt::Edges());
 }
 #endif
 
-void QAdwaitaDecorations::paint(QPaintDevice *device)
+Qt::Edges QAdwaitaDecorations::tiledEdges() const
 {
+    Qt::Edges edges;
 #ifdef HAS_QT6_SUPPORT
-    const Qt::WindowStates windowStates = waylandWindow()->windowStates();
-    const bool active = windowStates & Qt::WindowActive;
-    const bool tiled =
-            waylandWindow()->toplevelWindowTilingStates() != QWaylandWindow::WindowNoState;
-#else
-    const Qt::WindowStates windowStates = window()->windowStates();
-    const bool active = window()->handle()->isActive();
-    const bool tiled = false;
+    const QWaylandWindow::ToplevelWindowTilingStates tilingStates =
+            waylandWindow()->toplevelWindowTilingStates();
+    edges.setFlag(Qt::LeftEdge, tilingStates.testFlag(QWaylandWindow::WindowTiledLeft));
+    edges.setFlag(Qt::TopEdge, tilingStates.testFlag(QWaylandWindow::WindowTiledTop));
+    edges.setFlag(Qt::RightEdge, tilingStates.testFlag(QWaylandWindow::WindowTiledRight));
+    edges.setFlag(Qt::BottomEdge, tilingStates.testFlag(QWaylandWindow::WindowTiledBottom));
 #endif
-    const bool maximized = windowStates & Qt::WindowMaximized;
-
-    const QRect surfaceRect = windowContentGeometry();
+    return edges;
+}
 
-    const QColor borderColor = active ? m_colors[Border] : m_colors[BorderInactive];
-    const QColor backgroundColor = active ? m_colors[Background] : m_colors[BackgroundInactive];
-    const QColor foregroundColor = active ? m_colors[Foreground] : m_colors[ForegroundInactive];
+void QAdwaitaDecorations::paint(QPaintDevice *device)
+{
+    // Everything requested so far is going to be presented with this paint
+    m_pendingFullRepaint = false;
+    m_pendingRepaintRegion = QRegion();
+    m_visualState = currentVisualState();
+
+    const bool useDecorationSurface = updateDecorationSurface();
+    updateSurfaceRegions();
+
+    if (useDecorationSurface) {
+        // Window buffer keeps only the contents. Decorations are committed together
+        // with it this time, as their size or state might have changed with it.
+        const Geometry &geometry = decorationGeometry();
+        const QRect surfaceRect(QPoint(), geometry.surfaceRect.size());
+        QPainter p(device);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.setClipRegion(
+                QRegion(surfaceRect).subtracted(surfaceRect.marginsRemoved(geometry.margins)));
+        p.fillRect(surfaceRect, Qt::transparent);
+        p.end();
+
+        paintDecorationSurface(surfaceRect, true);
+        return;
+    }
 
     QPainter p(device);
-    p.setRenderHint(QPainter::Antialiasing);
-
-#ifdef HAS_QT6_SUPPORT
-    // Shadows
-    if (active && !(maximized || tiled)) {
-        if (m_shadowPixmap.size() != surfaceRect.size()) {
-            QPixmap source = QPixmap(surfaceRect.size());
-            source.fill(Qt::transparent);
-            {
-                QRect topHalf = surfaceRect.translated(ceShadowsWidth, ceShadowsWidth);
-                topHalf.setSize(QSize(surfaceRect.width() - (2 * ceShadowsWidth),
-                                      surfaceRect.height() / 2));
-
-                QRect bottomHalf = surfaceRect.translated(ceShadowsWidth, surfaceRect.height() / 2);
-                bottomHalf.setSize(QSize(surfaceRect.width() - (2 * ceShadowsWidth),
-                                         (surfaceRect.height() / 2) - ceShadowsWidth));
-
-                QPainter tmpPainter(&source);
-                tmpPainter.setBrush(borderColor);
-                tmpPainter.drawRoundedRect(topHalf, ceCornerRadius, ceCornerRadius);
-                tmpPainter.drawRect(bottomHalf);
-                tmpPainter.end();
-            }
-
-            QImage backgroundImage(surfaceRect.size(), QImage::Format_ARGB32_Premultiplied);
-            backgroundImage.fill(0);
-
-            QPainter backgroundPainter(&backgroundImage);
-            backgroundPainter.drawPixmap(QPointF(), source);
-            backgroundPainter.end();
-
-            QImage blurredImage(surfaceRect.size(), QImage::Format_ARGB32_Premultiplied);
-            blurredImage.fill(0);
-            {
-                QPainter blurPainter(&blurredImage);
-                qt_blurImage(&blurPainter, backgroundImage, 12, false, false);
-                blurPainter.end();
-            }
-            backgroundImage = blurredImage;
-
-            backgroundPainter.begin(&backgroundImage);
-            backgroundPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-            QRect rect = backgroundImage.rect().marginsRemoved(QMargins(8, 8, 8, 8));
-            backgroundPainter.fillRect(rect, QColor(0, 0, 0, 160));
-            backgroundPainter.end();
+    paintDecoration(&p);
+}
 
-            m_shadowPixmap = QPixmap::fromImage(backgroundImage);
-        }
+bool QAdwaitaDecorations::updateDecorationSurface()
+{
+    if (!QAdwaitaDecorationSurface::isEnabled())
+        return false;
 
-        QRect clips[] = { QRect(0, 0, surfaceRect.width(), margins().top()),
-                          QRect(0, margins().top(), margins().left(),
-                                surfaceRect.height() - margins().top() - margins().bottom()),
-                          QRect(0, surfaceRect.height() - margins().bottom(), surfaceRect.width(),
-                                margins().bottom()),
-                          QRect(surfaceRect.width() - margins().right(), margins().top(),
-                                margins().right(),
-                                surfaceRect.height() - margins().top() - margins().bottom()) };
-
-        for (int i = 0; i < 4; ++i) {
-            p.save();
-            p.setClipRect(clips[i]);
-            p.drawPixmap(QPoint(), m_shadowPixmap);
-            p.restore();
-        }
+    wl_surface *surface = waylandWindow()->wlSurface();
+    if (!surface) {
+        resetDecorationSurface();
+        return false;
     }
-#endif
 
-    // Titlebar and window border
-    {
-        QPainterPath path;
-#ifdef HAS_QT6_SUPPORT
-        const QPointF topLeft = { margins(ShadowsOnly).left() + 0.5,
-                                  margins(ShadowsOnly).top() - 0.5 };
-        const int titleBarWidth = surfaceRect.width() - margins(ShadowsOnly).left()
-                - margins(ShadowsOnly).right() - 0.5;
-#else
-        const QPointF topLeft = { 0.5, -0.5 };
-        const int titleBarWidth = surfaceRect.width() - 0.5;
-#endif
-        const int borderRectHeight =
-                surfaceRect.height() - margins().top() - margins().bottom() + 0.5;
-
-        if (maximized || tiled)
-            path.addRect(QRectF(topLeft, QSizeF(titleBarWidth, margins().top())));
-        else
-            path.addRoundedRect(
-                    QRectF(topLeft, QSizeF(titleBarWidth, margins().top() + ceCornerRadius)),
-                    ceCornerRadius, ceCornerRadius);
-
-        p.save();
-        p.setPen(borderColor);
-        p.fillPath(path.simplified(), backgroundColor);
-        p.drawPath(path);
-        p.drawRect(QRectF(topLeft.x(), margins().top(), titleBarWidth, borderRectHeight));
-        p.restore();
+    // Window surface is recreated when the window is hidden and shown again
+    if (!m_decorationSurface || m_decorationSurface->parentSurface() != surface) {
+        resetDecorationSurface();
+        m_decorationSurface = std::make_unique<QAdwaitaDecorationSurface>(waylandWindow());
+        m_geometry.regionsPublished = false;
     }
 
-    // Window title
-    {
-        const QRect top = QRect(margins().left(), margins().bottom(), surfaceRect.width(),
-                                margins().top() - margins().bottom());
-#if QT_VERSION >= 0x060700
-        const QString windowTitleText = waylandWindow()->windowTitle();
-#else
-        const QString windowTitleText = window()->title();
-#endif
-        if (!windowTitleText.isEmpty()) {
-            if (m_windowTitle.text() != windowTitleText) {
-                m_windowTitle.setText(windowTitleText);
-                m_windowTitle.prepare();
-            }
+    return m_decorationSurface->isValid();
+}
 
-            QRect titleBar = top;
-            if (m_placement == Right) {
-                titleBar.setLeft(margins().left());
-                titleBar.setRight(static_cast<int>(buttonRect(Minimize).left()) - 8);
-            } else {
-                titleBar.setLeft(static_cast<int>(buttonRect(Minimize).right()) + 8);
-                titleBar.setRight(surfaceRect.width() - margins().right());
-            }
+void QAdwaitaDecorations::resetDecorationSurface()
+{
+    if (!m_decorationSurface)
+        return;
 
-            p.save();
-            p.setClipRect(titleBar);
-            p.setPen(foregroundColor);
-            QSize size = m_windowTitle.size().toSize();
-            int dx = (top.width() - size.width()) / 2;
-            int dy = (top.height() - size.height()) / 2;
-            p.setFont(*m_font);
-            QPoint windowTitlePoint(top.topLeft().x() + dx, top.topLeft().y() + dy);
-            p.drawStaticText(windowTitlePoint, m_windowTitle);
-            p.restore();
-        }
+    // Callback of a destroyed surface would never arrive
+    if (m_frameCallbackSurface == m_decorationSurface->surface())
+        cancelFrameCallback();
+    m_decorationSurface.reset();
+}
+
+void QAdwaitaDecorations::paintDecorationSurface(const QRegion &region, bool synchronized)
+{
+    const Geometry &geometry = decorationGeometry();
+    const QRect surfaceRect(QPoint(), geometry.surfaceRect.size());
+
+    QImage *image = m_decorationSurface->beginPaint(surfaceRect.size(),
+                                                    qCeil(waylandWindow()->scale()));
+    if (!image) {
+        // All buffers are still used by the compositor, try again in a frame
+        m_pendingRepaintRegion += region;
+        m_repaintTimer.start(motionInterval());
+        return;
     }
 
-    // Buttons
     {
-        if (m_buttons.contains(Close))
-            paintButton(Close, &p);
-
-        if (m_buttons.contains(Maximize))
-            paintButton(Maximize, &p);
-
-        if (m_buttons.contains(Minimize))
-            paintButton(Minimize, &p);
+        // Buffers are swapped, always paint everything
+        QPainter p(image);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.fillRect(surfaceRect, Qt::transparent);
+        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        p.setClipRegion(
+                QRegion(surfaceRect).subtracted(surfaceRect.marginsRemoved(geometry.margins)));
+        paintDecoration(&p);
     }
-}
 
-static void renderFlatRoundedButtonFrame(QAdwaitaDecorations::Button button, QPainter *painter,
-                                         const QRect &rect, const QColor &color)
-{
-    painter->save();
-    painter->setRenderHint(QPainter::Antialiasing, true);
-    painter->setPen(Qt::NoPen);
-    painter->setBrush(color);
-    painter->drawEllipse(rect);
-    painter->restore();
+    requestFrameCallback(m_decorationSurface->surface());
+    m_decorationSurface->commit(region, synchronized);
 }
 
-static void renderButtonIcon(const QString &svgIcon, QPainter *painter, const QRect &rect,
-                             const QColor &color)
+void QAdwaitaDecorations::updateSurfaceRegions()
 {
-    painter->save();
-    painter->setRenderHints(QPainter::Antialiasing, true);
-
-    QString icon = svgIcon;
-    QRegularExpression regexp("fill=[\"']#[0-9A-F]{6}[\"']",
-                              QRegularExpression::CaseInsensitiveOption);
-    QRegularExpression regexpAlt("fill:#[0-9A-F]{6}", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpression regexpCurrentColor("fill=[\"']currentColor[\"']");
-    icon.replace(regexp, QString("fill=\"%1\"").arg(color.name()));
-    icon.replace(regexpAlt, QString("fill:%1").arg(color.name()));
-    icon.replace(regexpCurrentColor, QString("fill=\"%1\"").arg(color.name()));
-    QSvgRenderer svgRenderer(icon.toLocal8Bit());
-    svgRenderer.render(painter, rect);
+    // Published once per geometry change, before the commit of the new buffer
+    const Geometry &geometry = decorationGeometry();
+    if (geometry.regionsPublished)
+        return;
+    m_geometry.regionsPublished = true;
 
-    painter->restore();
-}
+    wl_surface *surface = waylandWindow()->wlSurface();
+    if (!surface)
+        return;
 
-static void renderButtonIcon(QAdwaitaDecorations::ButtonIcon buttonIcon, QPainter *painter,
-                             const QRect &rect)
-{
-    QString iconName = buttonMap[buttonIcon];
+    QRegion windowOpaqueRegion = geometry.opaqueRegion;
+    if (m_decorationSurface && m_decorationSurface->isValid()) {
+        // Window surface has only the contents
+        const QRect contentRect =
+                QRect(QPoint(), geometry.surfaceRect.size()).marginsRemoved(geometry.margins);
+        m_decorationSurface->setOpaqueRegion(windowOpaqueRegion.subtracted(contentRect));
+        windowOpaqueRegion &= contentRect;
+    }
 
-    painter->save();
-    painter->setRenderHints(QPainter::Antialiasing, true);
-    painter->drawPixmap(rect, QIcon::fromTheme(iconName).pixmap(ceButtonWidth, ceButtonWidth));
+    wl_region *opaqueRegion = waylandWindow()->display()->createRegion(windowOpaqueRegion);
+    wl_surface_set_opaque_region(surface, opaqueRegion);
+    wl_region_destroy(opaqueRegion);
 
-    painter->restore();
-}
+    // Input region is managed by Qt for masked windows and windows without input
+    if (!window()->mask().isEmpty() || window()->flags().testFlag(Qt::WindowTransparentForInput))
+        return;
 
-static QAdwaitaDecorations::ButtonIcon iconFromButtonAndState(QAdwaitaDecorations::Button button,
-                                                              bool maximized)
-{
-    if (button == QAdwaitaDecorations::Close)
-        return QAdwaitaDecorations::CloseIcon;
-    else if (button == QAdwaitaDecorations::Minimize)
-        return QAdwaitaDecorations::MinimizeIcon;
-    else if (button == QAdwaitaDecorations::Maximize && maximized)
-        return QAdwaitaDecorations::RestoreIcon;
-    else
-        return QAdwaitaDecorations::MaximizeIcon;
+    if (geometry.inputRegion == QRegion(QRect(QPoint(), geometry.surfaceRect.size()))) {
+        // No shadows, whole surface takes input
+        wl_surface_set_input_region(surface, nullptr);
+    } else {
+        wl_region *inputRegion = waylandWindow()->display()->createRegion(geometry.inputRegion);
+        wl_surface_set_input_region(surface, inputRegion);
+        wl_region_destroy(inputRegion);
+    }
 }
 
-void QAdwaitaDecorations::paintButton(Button button, QPainter *painter)
+void QAdwaitaDecorations::paintDecoration(QPainter *painter)
 {
-#ifdef HAS_QT6_SUPPORT
-    const Qt::WindowStates windowStates = waylandWindow()->windowStates();
-    const bool active = windowStates & Qt::WindowActive;
-#else
-    const Qt::WindowStates windowStates = window()->windowStates();
-    const bool active = window()->handle()->isActive();
-#endif
-    const bool maximized = windowStates & Qt::WindowMaximized;
-
-    QColor activeBackgroundColor;
-    if (m_clicking == button)
-        activeBackgroundColor = m_colors[PressedButtonBackground];
-    else if (m_hoveredButtons.testFlag(button))
-        activeBackgroundColor = m_colors[HoveredButtonBackground];
-    else
-        activeBackgroundColor = m_colors[ButtonBackground];
-
-    const QColor buttonBackgroundColor =
-            active ? activeBackgroundColor : m_colors[ButtonBackgroundInactive];
-    const QColor foregroundColor = active ? m_colors[Foreground] : m_colors[ForegroundInactive];
-
-    const QRect btnRect = buttonRect(button).toRect();
-    renderFlatRoundedButtonFrame(button, painter, btnRect, buttonBackgroundColor);
-
-    QRect adjustedBtnRect = btnRect;
-    adjustedBtnRect.setSize(QSize(16, 16));
-    adjustedBtnRect.translate(4, 4);
-    const QString svgIcon = m_icons[iconFromButtonAndState(button, maximized)];
-    if (!svgIcon.isEmpty())
-        renderButtonIcon(svgIcon, painter, adjustedBtnRect, foregroundColor);
-    else // Fallback to use QIcon
-        renderButtonIcon(iconFromButtonAndState(button, maximized), painter, adjustedBtnRect);
+    m_renderer->paint(painter, m_visualState, decorationGeometry());
 }
 
 bool QAdwaitaDecorations::clickButton(Qt::MouseButtons b, Button btn)
 {
-    auto repaint = qScopeGuard([this] { forceRepaint(); });
-
     if (isLeftClicked(b)) {
         m_clicking = btn;
+        updateVisualState();
         return false;
     } else if (isLeftReleased(b)) {
-        if (m_clicking == btn) {
-            m_clicking = None;
-            return true;
-        } else {
-            m_clicking = None;
-        }
+        const bool clicked = m_clicking == btn;
+        m_clicking = Button::None;
+        updateVisualState();
+        return clicked;
     }
     return false;
 }
@@ -665,36 +541,95 @@ bool QAdwaitaDecorations::handleMouse(QWaylandInputDevice *inputDevice, const QP
                                       Qt::KeyboardModifiers mods)
 {
     Q_UNUSED(global)
+    Q_UNUSED(mods)
 
-    if (local.y() > margins().top()) {
-        updateButtonHoverState(Button::None);
+    if (b != m_mouseButtons) {
+        // Presses and releases are handled right away, their position supersedes
+        // any motion still waiting
+        m_motionTimer.stop();
+        m_pendingMotion.inputDevice.clear();
+        processMouse(inputDevice, local, b);
+        return false;
+    }
+
+    // Only the latest position per frame matters for motion
+    if (m_motionTimer.isActive()) {
+        if (m_pendingMotion.inputDevice == inputDevice) {
+            m_pendingMotion.local = local;
+            return false;
+        }
+        m_motionTimer.stop();
+        processPendingMotion();
+    }
+
+    const int interval = motionInterval();
+    if (m_lastMotion.isValid() && m_lastMotion.elapsed() < interval) {
+        m_pendingMotion.inputDevice = inputDevice;
+        m_pendingMotion.local = local;
+        m_pendingMotion.buttons = b;
+        m_motionTimer.start(interval - static_cast<int>(m_lastMotion.elapsed()));
+        return false;
     }
 
+    processMouse(inputDevice, local, b);
+    return false;
+}
+
+void QAdwaitaDecorations::processPendingMotion()
+{
+    QWaylandInputDevice *inputDevice = m_pendingMotion.inputDevice;
+    m_pendingMotion.inputDevice.clear();
+    if (inputDevice)
+        processMouse(inputDevice, m_pendingMotion.local, m_pendingMotion.buttons);
+}
+
+int QAdwaitaDecorations::motionInterval() const
+{
+    const QScreen *screen = window()->screen();
+    const int refreshRate = screen ? qRound(screen->refreshRate()) : 60;
+    return 1000 / qMax(refreshRate, 1);
+}
+
+void QAdwaitaDecorations::processMouse(QWaylandInputDevice *inputDevice, const QPointF &local,
+                                       Qt::MouseButtons b)
+{
+    m_lastMotion.start();
+
     // Figure out what area mouse is in
-    QRect surfaceRect = windowContentGeometry();
-    if (local.y() <= surfaceRect.top() + margins().top()) {
-        processMouseTop(inputDevice, local, b, mods);
-    } else if (local.y() > surfaceRect.bottom() - margins().bottom()) {
-        processMouseBottom(inputDevice, local, b, mods);
-    } else if (local.x() <= surfaceRect.left() + margins().left()) {
-        processMouseLeft(inputDevice, local, b, mods);
-    } else if (local.x() > surfaceRect.right() - margins().right()) {
-        processMouseRight(inputDevice, local, b, mods);
-    } else {
-#if QT_CONFIG(cursor)
-        waylandWindow()->restoreMouseCursor(inputDevice);
-#endif
+    const HitZone zone = hitTest(local);
+    switch (zone) {
+    case ContentZone:
+        updateButtonHoverState(Button::None);
+        restoreCursorShape(inputDevice);
+        break;
+    case TitleZone:
+        updateButtonHoverState(Button::None);
+        processMouseTitle(inputDevice, local, b);
+        break;
+    case CloseZone:
+        processMouseButton(Button::Close, b);
+        break;
+    case MaximizeZone:
+        processMouseButton(Button::Maximize, b);
+        break;
+    case MinimizeZone:
+        processMouseButton(Button::Minimize, b);
+        break;
+    default:
+        updateButtonHoverState(Button::None);
+        processMouseResize(inputDevice, zone, b);
+        break;
     }
 
     // Reset clicking state in case a button press is released outside
     // the button area
-    if (isLeftReleased(b)) {
-        m_clicking = None;
-        forceRepaint();
+    if (isLeftReleased(b) && m_clicking != Button::None) {
+        m_clicking = Button::None;
+        updateVisualState();
     }
 
+    m_mouseButtons = b;
     setMouseButtons(b);
-    return false;
 }
 
 #if QT_VERSION >= 0x060000
@@ -716,16 +651,22 @@ bool QAdwaitaDecorations::handleTouch(QWaylandInputDevice *inputDevice, const QP
     bool handled = state == Qt::TouchPointPressed;
 #endif
     if (handled) {
-        if (buttonRect(Close).contains(local)) {
-            QWindowSystemInterface::handleCloseEvent(window());
-        } else if (m_buttons.contains(Maximize) && buttonRect(Maximize).contains(local)) {
-            window()->setWindowStates(window()->windowStates() ^ Qt::WindowMaximized);
-        } else if (m_buttons.contains(Minimize) && buttonRect(Minimize).contains(local)) {
-            window()->setWindowState(Qt::WindowMinimized);
-        } else if (local.y() <= margins().top()) {
+        switch (hitTest(local)) {
+        case CloseZone:
+            triggerButton(Button::Close);
+            break;
+        case MaximizeZone:
+            triggerButton(Button::Maximize);
+            break;
+        case MinimizeZone:
+            triggerButton(Button::Minimize);
+            break;
+        case TitleZone:
             waylandWindow()->shellSurface()->move(inputDevice);
-        } else {
+            break;
+        default:
             handled = false;
+            break;
         }
     }
 
@@ -743,149 +684,390 @@ QRect QAdwaitaDecorations::windowContentGeometry() const
 
 void QAdwaitaDecorations::forceRepaint()
 {
-    // Set dirty flag
-    if (waylandWindow()->decoration()) {
-        waylandWindow()->decoration()->update();
-    }
-    // Force re-paint
-    // NOTE: not sure it's correct, but it's the only way to make it work
-    if (waylandWindow()->backingStore()) {
-        waylandWindow()->backingStore()->flush(window(), QRegion(), QPoint());
-    }
+    m_pendingFullRepaint = true;
+    scheduleRepaint();
 }
 
-void QAdwaitaDecorations::processMouseTop(QWaylandInputDevice *inputDevice, const QPointF &local,
-                                          Qt::MouseButtons b, Qt::KeyboardModifiers mods)
+void QAdwaitaDecorations::repaintRegion(const QRegion &region)
 {
-    Q_UNUSED(mods)
+    if (region.isEmpty())
+        return;
 
-    QDateTime currentDateTime = QDateTime::currentDateTime();
-    QRect surfaceRect = windowContentGeometry();
+    m_pendingRepaintRegion += region;
+    scheduleRepaint();
+}
 
-    if (!buttonRect(Close).contains(local) && !buttonRect(Maximize).contains(local)
-        && !buttonRect(Minimize).contains(local)) {
-        updateButtonHoverState(Button::None);
+void QAdwaitaDecorations::scheduleRepaint()
+{
+    // Waiting for the compositor to present the previous repaint, the frame
+    // callback will pick up everything requested in the meantime
+    if (m_frameCallback)
+        return;
+
+    // Collect all requests from the current event loop iteration
+    if (!m_repaintTimer.isActive())
+        m_repaintTimer.start(0);
+}
+
+void QAdwaitaDecorations::frameCallbackDone(void *data, wl_callback *callback, uint32_t time)
+{
+    Q_UNUSED(time)
+
+    auto *decorations = static_cast<QAdwaitaDecorations *>(data);
+    wl_callback_destroy(callback);
+    decorations->m_frameCallback = nullptr;
+    decorations->m_frameCallbackSurface = nullptr;
+    decorations->m_repaintTimer.stop();
+    decorations->performRepaint();
+}
+
+void QAdwaitaDecorations::requestFrameCallback(wl_surface *surface)
+{
+    static const wl_callback_listener listener = { &QAdwaitaDecorations::frameCallbackDone };
+
+    if (!surface)
+        return;
+
+    // Only one callback at a time, the newest commit is the one to wait for
+    cancelFrameCallback();
+
+    // Has to be requested before the commit
+    m_frameCallback = wl_surface_frame(surface);
+    m_frameCallbackSurface = surface;
+    wl_callback_add_listener(m_frameCallback, &listener, this);
+
+    // Hidden windows don't get frame callbacks, don't wait forever
+    m_repaintTimer.start(ceFrameCallbackTimeout);
+}
+
+void QAdwaitaDecorations::cancelFrameCallback()
+{
+    if (!m_frameCallback)
+        return;
+
+    wl_callback_destroy(m_frameCallback);
+    m_frameCallback = nullptr;
+    m_frameCallbackSurface = nullptr;
+}
+
+void QAdwaitaDecorations::performRepaint()
+{
+    // Frame callback didn't arrive in time
+    cancelFrameCallback();
+
+    if (!m_pendingFullRepaint && m_pendingRepaintRegion.isEmpty())
+        return;
+
+    const bool fullRepaint = m_pendingFullRepaint;
+    const QRegion region = m_pendingRepaintRegion;
+    m_pendingFullRepaint = false;
+    m_pendingRepaintRegion = QRegion();
+
+    // Decorations on their own surface don't need the window to be committed
+    if (updateDecorationSurface()) {
+        updateSurfaceRegions();
+        const QRect surfaceRect(QPoint(), decorationGeometry().surfaceRect.size());
+        paintDecorationSurface(fullRepaint ? QRegion(surfaceRect) : region, false);
+        return;
     }
 
-    if (local.y() <= surfaceRect.top() + margins().bottom()) {
-        if (local.x() <= margins().left()) {
-            // top left bit
-#if QT_CONFIG(cursor)
-            waylandWindow()->setMouseCursor(inputDevice, Qt::SizeFDiagCursor);
-#endif
-            startResize(inputDevice, Qt::TopEdge | Qt::LeftEdge, b);
-        } else if (local.x() > surfaceRect.right() - margins().left()) {
-            // top right bit
-#if QT_CONFIG(cursor)
-            waylandWindow()->setMouseCursor(inputDevice, Qt::SizeBDiagCursor);
-#endif
-            startResize(inputDevice, Qt::TopEdge | Qt::RightEdge, b);
-        } else {
-            // top resize bit
-#if QT_CONFIG(cursor)
-            waylandWindow()->setMouseCursor(inputDevice, Qt::SizeVerCursor);
-#endif
-            startResize(inputDevice, Qt::TopEdge, b);
+    // Whole decoration is going to be repainted anyway, or there is no shm buffer
+    // to paint into (e.g. OpenGL windows)
+    QWaylandShmBackingStore *backingStore = waylandWindow()->backingStore();
+    QImage *image = backingStore ? backingStore->entireSurface() : nullptr;
+    if (fullRepaint || isDirty() || !image || image->isNull()) {
+        // Set dirty flag
+        if (waylandWindow()->decoration()) {
+            waylandWindow()->decoration()->update();
         }
-    } else if (local.x() <= surfaceRect.left() + margins().left()) {
-        processMouseLeft(inputDevice, local, b, mods);
-    } else if (local.x() > surfaceRect.right() - margins().right()) {
-        processMouseRight(inputDevice, local, b, mods);
-    } else if (buttonRect(Close).contains(local)) {
-        if (clickButton(b, Close)) {
-            QWindowSystemInterface::handleCloseEvent(window());
-            m_hoveredButtons.setFlag(Close, false);
+        // Force re-paint
+        // NOTE: not sure it's correct, but it's the only way to make it work
+        if (backingStore) {
+            requestFrameCallback(waylandWindow()->wlSurface());
+            backingStore->flush(window(), QRegion(), QPoint());
         }
-        updateButtonHoverState(Close);
-    } else if (m_buttons.contains(Maximize) && buttonRect(Maximize).contains(local)) {
-        updateButtonHoverState(Maximize);
-        if (clickButton(b, Maximize)) {
-            window()->setWindowStates(window()->windowStates() ^ Qt::WindowMaximized);
-            m_hoveredButtons.setFlag(Maximize, false);
+        return;
+    }
+
+    // Never touch the window content
+    const Geometry &geometry = decorationGeometry();
+    const QRect surfaceRect(QPoint(), geometry.surfaceRect.size());
+    const QRegion decorationRegion =
+            QRegion(surfaceRect)
+                    .subtracted(surfaceRect.marginsRemoved(geometry.margins))
+                    .intersected(region);
+    if (decorationRegion.isEmpty())
+        return;
+
+    {
+        QPainter p(image);
+        if (!p.isActive()) {
+            forceRepaint();
+            return;
         }
-    } else if (m_buttons.contains(Minimize) && buttonRect(Minimize).contains(local)) {
-        updateButtonHoverState(Minimize);
-        if (clickButton(b, Minimize)) {
-            window()->setWindowState(Qt::WindowMinimized);
-            m_hoveredButtons.setFlag(Minimize, false);
+        p.setClipRegion(decorationRegion);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.fillRect(decorationRegion.boundingRect(), Qt::transparent);
+        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        paintDecoration(&p);
+    }
+
+    // Submit only the repainted area, flush() expects it relative to the content
+    updateSurfaceRegions();
+    requestFrameCallback(waylandWindow()->wlSurface());
+    backingStore->flush(window(),
+                        decorationRegion.translated(-geometry.margins.left(),
+                                                    -geometry.margins.top()),
+                        QPoint());
+}
+
+QRegion QAdwaitaDecorations::buttonsRegion(Buttons buttons) const
+{
+    QRegion region;
+    for (const Button button : { Button::Close, Button::Maximize, Button::Minimize }) {
+        if (buttons.testFlag(button) && m_buttons.contains(button))
+            region += buttonRect(button).toAlignedRect().adjusted(-1, -1, 1, 1);
+    }
+    return region;
+}
+
+QAdwaitaDecorations::HitZone QAdwaitaDecorations::hitTest(const QPointF &local) const
+{
+    // Rows are the top resize band, titlebar, sides and bottom resize band,
+    // columns are the left resize band, middle and right resize band
+    static constexpr HitZone zones[4][3] = {
+        { TopLeftZone, TopZone, TopRightZone },
+        { LeftZone, TitleZone, RightZone },
+        { LeftZone, ContentZone, RightZone },
+        { BottomLeftZone, BottomZone, BottomRightZone },
+    };
+
+    const Geometry &geometry = decorationGeometry();
+
+    int row = 2;
+    if (local.y() <= geometry.topEdge)
+        row = 0;
+    else if (local.y() <= geometry.titleBottom)
+        row = 1;
+    else if (local.y() > geometry.bottomEdge)
+        row = 3;
+
+    int column = 1;
+    if (local.x() <= geometry.leftEdge)
+        column = 0;
+    else if (local.x() > geometry.rightEdge)
+        column = 2;
+
+    const HitZone zone = zones[row][column];
+    if (zone != TitleZone)
+        return zone;
+
+    // At most three buttons
+    for (const auto &buttonZone : geometry.buttonZones) {
+        if (buttonZone.second.contains(local)) {
+            switch (buttonZone.first) {
+            case Button::Close:
+                return CloseZone;
+            case Button::Maximize:
+                return MaximizeZone;
+            default:
+                return MinimizeZone;
+            }
         }
-    } else if (doubleClickButton(b, local, currentDateTime)) {
+    }
+
+    return TitleZone;
+}
+
+void QAdwaitaDecorations::processMouseResize(QWaylandInputDevice *inputDevice, HitZone zone,
+                                             Qt::MouseButtons b)
+{
+    Qt::Edges edges;
+    Qt::CursorShape cursorShape = Qt::ArrowCursor;
+    switch (zone) {
+    case TopLeftZone:
+        edges = Qt::TopEdge | Qt::LeftEdge;
+        cursorShape = Qt::SizeFDiagCursor;
+        break;
+    case TopZone:
+        edges = Qt::TopEdge;
+        cursorShape = Qt::SizeVerCursor;
+        break;
+    case TopRightZone:
+        edges = Qt::TopEdge | Qt::RightEdge;
+        cursorShape = Qt::SizeBDiagCursor;
+        break;
+    case LeftZone:
+        edges = Qt::LeftEdge;
+        cursorShape = Qt::SizeHorCursor;
+        break;
+    case RightZone:
+        edges = Qt::RightEdge;
+        cursorShape = Qt::SizeHorCursor;
+        break;
+    case BottomLeftZone:
+        edges = Qt::BottomEdge | Qt::LeftEdge;
+        cursorShape = Qt::SizeBDiagCursor;
+        break;
+    case BottomZone:
+        edges = Qt::BottomEdge;
+        cursorShape = Qt::SizeVerCursor;
+        break;
+    case BottomRightZone:
+        edges = Qt::BottomEdge | Qt::RightEdge;
+        cursorShape = Qt::SizeFDiagCursor;
+        break;
+    default:
+        return;
+    }
+
+    setCursorShape(inputDevice, cursorShape);
+    startResize(inputDevice, edges, b);
+}
+
+void QAdwaitaDecorations::processMouseButton(Button button, Qt::MouseButtons b)
+{
+    updateButtonHoverState(button);
+    if (clickButton(b, button)) {
+        triggerButton(button);
+        m_hoveredButtons.setFlag(button, false);
+    }
+}
+
+void QAdwaitaDecorations::processMouseTitle(QWaylandInputDevice *inputDevice, const QPointF &local,
+                                            Qt::MouseButtons b)
+{
+    if (doubleClickButton(b, local, QDateTime::currentDateTime())) {
         window()->setWindowStates(window()->windowStates() ^ Qt::WindowMaximized);
     } else {
         // Show window menu
         if (b == Qt::MouseButton::RightButton) {
             waylandWindow()->shellSurface()->showWindowMenu(inputDevice);
         }
-#if QT_CONFIG(cursor)
-        waylandWindow()->restoreMouseCursor(inputDevice);
-#endif
+        restoreCursorShape(inputDevice);
         startMove(inputDevice, b);
     }
 }
 
-void QAdwaitaDecorations::processMouseBottom(QWaylandInputDevice *inputDevice, const QPointF &local,
-                                             Qt::MouseButtons b, Qt::KeyboardModifiers mods)
+void QAdwaitaDecorations::triggerButton(Button button)
 {
-    Q_UNUSED(mods)
-    if (local.x() <= margins().left()) {
-        // bottom left bit
-#if QT_CONFIG(cursor)
-        waylandWindow()->setMouseCursor(inputDevice, Qt::SizeBDiagCursor);
-#endif
-        startResize(inputDevice, Qt::BottomEdge | Qt::LeftEdge, b);
-    } else if (local.x() > window()->width() + margins().right()) {
-        // bottom right bit
-#if QT_CONFIG(cursor)
-        waylandWindow()->setMouseCursor(inputDevice, Qt::SizeFDiagCursor);
-#endif
-        startResize(inputDevice, Qt::BottomEdge | Qt::RightEdge, b);
-    } else {
-        // bottom bit
-#if QT_CONFIG(cursor)
-        waylandWindow()->setMouseCursor(inputDevice, Qt::SizeVerCursor);
-#endif
-        startResize(inputDevice, Qt::BottomEdge, b);
-    }
+    if (button == Button::Close)
+        QWindowSystemInterface::handleCloseEvent(window());
+    else if (button == Button::Maximize)
+        window()->setWindowStates(window()->windowStates() ^ Qt::WindowMaximized);
+    else if (button == Button::Minimize)
+        window()->setWindowState(Qt::WindowMinimized);
 }
 
-void QAdwaitaDecorations::processMouseLeft(QWaylandInputDevice *inputDevice, const QPointF &local,
-                                           Qt::MouseButtons b, Qt::KeyboardModifiers mods)
+void QAdwaitaDecorations::setCursorShape(QWaylandInputDevice *inputDevice, Qt::CursorShape shape)
 {
-    Q_UNUSED(local)
-    Q_UNUSED(mods)
 #if QT_CONFIG(cursor)
-    waylandWindow()->setMouseCursor(inputDevice, Qt::SizeHorCursor);
+    // Qt picks wp_cursor_shape_v1 itself when the compositor supports it
+    if (updateCursorState(inputDevice, false, shape))
+        waylandWindow()->setMouseCursor(inputDevice, shape);
+#else
+    Q_UNUSED(inputDevice)
+    Q_UNUSED(shape)
 #endif
-    startResize(inputDevice, Qt::LeftEdge, b);
 }
 
-void QAdwaitaDecorations::processMouseRight(QWaylandInputDevice *inputDevice, const QPointF &local,
-                                            Qt::MouseButtons b, Qt::KeyboardModifiers mods)
+void QAdwaitaDecorations::restoreCursorShape(QWaylandInputDevice *inputDevice)
 {
-    Q_UNUSED(local)
-    Q_UNUSED(mods)
 #if QT_CONFIG(cursor)
-    waylandWindow()->setMouseCursor(inputDevice, Qt::SizeHorCursor);
+    if (updateCursorState(inputDevice, true, Qt::ArrowCursor))
+        waylandWindow()->restoreMouseCursor(inputDevice);
+#else
+    Q_UNUSED(inputDevice)
 #endif
-    startResize(inputDevice, Qt::RightEdge, b);
+}
+
+bool QAdwaitaDecorations::updateCursorState(QWaylandInputDevice *inputDevice, bool restored,
+                                            Qt::CursorShape shape)
+{
+    // Cursor has to be set again after the pointer re-enters the surface
+    const uint32_t enterSerial = inputDevice->pointer() ? inputDevice->pointer()->mEnterSerial : 0;
+
+    auto it = m_cursorStates.find(inputDevice);
+    if (it != m_cursorStates.end() && it->enterSerial == enterSerial && it->restored == restored
+        && (restored || it->shape == shape)) {
+        return false;
+    }
+
+    CursorState state;
+    state.enterSerial = enterSerial;
+    state.restored = restored;
+    state.shape = shape;
+    m_cursorStates.insert(inputDevice, state);
+    return true;
 }
 
 bool QAdwaitaDecorations::updateButtonHoverState(Button hoveredButton)
 {
-    bool currentCloseButtonState = m_hoveredButtons.testFlag(Close);
-    bool currentMaximizeButtonState = m_hoveredButtons.testFlag(Maximize);
-    bool currentMinimizeButtonState = m_hoveredButtons.testFlag(Minimize);
+    const Buttons previousHoveredButtons = m_hoveredButtons;
 
-    m_hoveredButtons.setFlag(Close, hoveredButton == Button::Close);
-    m_hoveredButtons.setFlag(Maximize, hoveredButton == Button::Maximize);
-    m_hoveredButtons.setFlag(Minimize, hoveredButton == Button::Minimize);
+    m_hoveredButtons.setFlag(Button::Close, hoveredButton == Button::Close);
+    m_hoveredButtons.setFlag(Button::Maximize, hoveredButton == Button::Maximize);
+    m_hoveredButtons.setFlag(Button::Minimize, hoveredButton == Button::Minimize);
 
-    if (m_hoveredButtons.testFlag(Close) != currentCloseButtonState
-        || m_hoveredButtons.testFlag(Maximize) != currentMaximizeButtonState
-        || m_hoveredButtons.testFlag(Minimize) != currentMinimizeButtonState) {
+    if (m_hoveredButtons == previousHoveredButtons)
+        return false;
+
+    updateVisualState();
+    return true;
+}
+
+QAdwaitaDecorationRenderer::State QAdwaitaDecorations::currentVisualState() const
+{
+    QAdwaitaDecorationRenderer::State state;
+    state.size = windowContentGeometry().size();
+#ifdef HAS_QT6_SUPPORT
+    state.active = waylandWindow()->windowStates() & Qt::WindowActive;
+    state.maximized = waylandWindow()->windowStates() & Qt::WindowMaximized;
+#else
+    state.active = window()->handle()->isActive();
+    state.maximized = window()->windowStates() & Qt::WindowMaximized;
+#endif
+    state.tiledEdges = tiledEdges();
+    state.translucent = window()->format().hasAlpha();
+#if QT_VERSION >= 0x060700
+    state.title = waylandWindow()->windowTitle();
+#else
+    state.title = window()->title();
+#endif
+    state.colors = m_colors;
+    state.font = *m_font;
+    state.placement = m_placement;
+    state.buttons = m_buttons;
+    state.hoveredButtons = m_hoveredButtons;
+    state.pressedButton = m_clicking;
+    return state;
+}
+
+bool QAdwaitaDecorations::updateVisualState()
+{
+    const QAdwaitaDecorationRenderer::State previous =
+            std::exchange(m_visualState, currentVisualState());
+    const QAdwaitaDecorationRenderer::State &current = m_visualState;
+
+    if (previous.active != current.active || previous.maximized != current.maximized
+        || previous.tiledEdges != current.tiledEdges || previous.colors != current.colors
+        || previous.font != current.font || previous.placement != current.placement
+        || previous.buttons != current.buttons) {
         forceRepaint();
         return true;
     }
 
-    return false;
+    // Only buttons which changed their state need to be repainted
+    Buttons changedButtons = previous.hoveredButtons ^ current.hoveredButtons;
+    if (previous.pressedButton != current.pressedButton)
+        changedButtons |= Buttons(previous.pressedButton) | current.pressedButton;
+    QRegion region = buttonsRegion(changedButtons);
+    // Title never leaves its rect
+    if (previous.title != current.title)
+        region += decorationGeometry().titleRect;
+    if (region.isEmpty())
+        return false;
+
+    repaintRegion(region);
+    return true;
 }
@@ -20,41 +20,52 @@
 #ifndef QADWAITA_DECORATIONS_H
 #define QADWAITA_DECORATIONS_H
 
+#include "qadwaitadecorationrenderer.h"
+
 #include <QtCore/QDateTime>
-#include <QtGui/QPixmap>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+#include <QtGui/QFont>
 
 #include <QtWaylandClient/private/qwaylandabstractdecoration_p.h>
 
 #include <memory>
+#include <utility>
 
 using namespace QtWaylandClient;
 
+class QAdwaitaDecorationSurface;
+class QAdwaitaIconStore;
 class QDBusVariant;
 class QPainter;
+struct wl_callback;
+struct wl_surface;
 
 class QAdwaitaDecorations : public QWaylandAbstractDecoration
 {
     Q_OBJECT
 public:
-    enum ColorType {
-        Background,
-        BackgroundInactive,
-        Foreground,
-        ForegroundInactive,
-        Border,
-        BorderInactive,
-        ButtonBackground,
-        ButtonBackgroundInactive,
-        HoveredButtonBackground,
-        PressedButtonBackground
+    using Button = QAdwaitaDecorationRenderer::Button;
+    using Buttons = QAdwaitaDecorationRenderer::Buttons;
+    enum HitZone {
+        ContentZone,
+        TopLeftZone,
+        TopZone,
+        TopRightZone,
+        LeftZone,
+        RightZone,
+        BottomLeftZone,
+        BottomZone,
+        BottomRightZone,
+        TitleZone,
+        CloseZone,
+        MaximizeZone,
+        MinimizeZone
     };
-    enum Placement { Left = 0, Right = 1 };
-    enum Button { None = 0x0, Close = 0x1, Minimize = 0x02, Maximize = 0x04 };
-    Q_DECLARE_FLAGS(Buttons, Button);
-    enum ButtonIcon { CloseIcon, MinimizeIcon, MaximizeIcon, RestoreIcon };
 
     QAdwaitaDecorations();
-    virtual ~QAdwaitaDecorations() = default;
+    virtual ~QAdwaitaDecorations();
 
 protected:
 #ifdef HAS_QT6_SUPPORT
@@ -63,7 +74,7 @@ protected:
     QMargins margins() const override;
 #endif
     void paint(QPaintDevice *device) override;
-    void paintButton(Button button, QPainter *painter);
+    void paintDecoration(QPainter *painter);
     bool handleMouse(QWaylandInputDevice *inputDevice, const QPointF &local, const QPointF &global,
                      Qt::MouseButtons b, Qt::KeyboardModifiers mods) override;
 #if QT_VERSION >= 0x060000
@@ -81,43 +92,119 @@ private:
     void initConfiguration();
     void updateColors(bool useDarkColors);
     void updateIcons();
+    void loadIcons();
     void updateTitlebarLayout(const QString &layout);
     QRect windowContentGeometry() const;
 
+    // Layout of the decoration, recomputed only when size, states or button layout change
+    struct Geometry : QAdwaitaDecorationRenderer::Geometry
+    {
+        bool valid = false;
+        QSize size;
+        bool maximized = false;
+        Qt::Edges tiledEdges;
+
+        // Hit-test bands, see hitTest()
+        int leftEdge = 0;
+        int rightEdge = 0;
+        int topEdge = 0;
+        int titleBottom = 0;
+        int bottomEdge = 0;
+        QList<std::pair<Button, QRectF>> buttonZones;
+
+        QRegion inputRegion;
+        bool regionsPublished = false;
+    };
+    const Geometry &decorationGeometry() const;
+    void updateSurfaceRegions();
+    // Optional subsurface for the decorations, see QAdwaitaDecorationSurface
+    bool updateDecorationSurface();
+    void resetDecorationSurface();
+    void paintDecorationSurface(const QRegion &region, bool synchronized);
+
+    Qt::Edges tiledEdges() const;
+    QAdwaitaDecorationRenderer::State currentVisualState() const;
+    bool updateVisualState();
+
+    // Repaints are paced by frame callbacks, at most one per frame
     void forceRepaint();
-
-    void processMouseTop(QWaylandInputDevice *inputDevice, const QPointF &local, Qt::MouseButtons b,
-                         Qt::KeyboardModifiers mods);
-    void processMouseBottom(QWaylandInputDevice *inputDevice, const QPointF &local,
-                            Qt::MouseButtons b, Qt::KeyboardModifiers mods);
-    void processMouseLeft(QWaylandInputDevice *inputDevice, const QPointF &local,
-                          Qt::MouseButtons b, Qt::KeyboardModifiers mods);
-    void processMouseRight(QWaylandInputDevice *inputDevice, const QPointF &local,
-                           Qt::MouseButtons b, Qt::KeyboardModifiers mods);
+    void repaintRegion(const QRegion &region);
+    void scheduleRepaint();
+    void performRepaint();
+    void requestFrameCallback(wl_surface *surface);
+    void cancelFrameCallback();
+    static void frameCallbackDone(void *data, wl_callback *callback, uint32_t time);
+
+    // Pointer motion is processed at most once per frame
+    void processPendingMotion();
+    int motionInterval() const;
+    void processMouse(QWaylandInputDevice *inputDevice, const QPointF &local, Qt::MouseButtons b);
+
+    HitZone hitTest(const QPointF &local) const;
+    void processMouseResize(QWaylandInputDevice *inputDevice, HitZone zone, Qt::MouseButtons b);
+    void processMouseButton(Button button, Qt::MouseButtons b);
+    void processMouseTitle(QWaylandInputDevice *inputDevice, const QPointF &local,
+                           Qt::MouseButtons b);
+    void triggerButton(Button button);
+
+    // Cursor is only sent to the compositor when it really changes
+    void setCursorShape(QWaylandInputDevice *inputDevice, Qt::CursorShape shape);
+    void restoreCursorShape(QWaylandInputDevice *inputDevice);
+    bool updateCursorState(QWaylandInputDevice *inputDevice, bool restored, Qt::CursorShape shape);
 
     bool clickButton(Qt::MouseButtons b, Button btn);
     bool doubleClickButton(Qt::MouseButtons b, const QPointF &local, const QDateTime &currentTime);
     bool updateButtonHoverState(Button hoveredButton);
 
     QRectF buttonRect(Button button) const;
+    QRegion buttonsRegion(Buttons buttons) const;
 
     // Default GNOME configuraiton
-    Placement m_placement = Right;
+    QAdwaitaDecorationRenderer::Placement m_placement = QAdwaitaDecorationRenderer::Right;
     QMap<Button, uint> m_buttons;
 
-    QStaticText m_windowTitle;
-    Button m_clicking = None;
+    Button m_clicking = Button::None;
 
-    Buttons m_hoveredButtons = None;
+    Buttons m_hoveredButtons = Button::None;
     QDateTime m_lastButtonClick;
     QPointF m_lastButtonClickPosition;
 
-    QMap<ColorType, QColor> m_colors;
+    QMap<QAdwaitaDecorationRenderer::ColorType, QColor> m_colors;
     std::unique_ptr<QFont> m_font;
-    QPixmap m_shadowPixmap;
-    QMap<ButtonIcon, QString> m_icons;
-};
+    bool m_useBakedIcons = false;
+    std::shared_ptr<QAdwaitaIconStore> m_iconStore;
+    std::unique_ptr<QAdwaitaDecorationRenderer> m_renderer;
+
+    QTimer m_repaintTimer;
+    wl_callback *m_frameCallback = nullptr;
+    // Surface the callback was requested for, it's cancelled when the surface goes away
+    wl_surface *m_frameCallbackSurface = nullptr;
+    std::unique_ptr<QAdwaitaDecorationSurface> m_decorationSurface;
+    bool m_pendingFullRepaint = false;
+    QRegion m_pendingRepaintRegion;
+    // State of the last painted or scheduled decoration
+    QAdwaitaDecorationRenderer::State m_visualState;
+    mutable Geometry m_geometry;
+
+    struct CursorState
+    {
+        uint32_t enterSerial = 0;
+        // Window cursor is used, not one set by the decoration
+        bool restored = true;
+        Qt::CursorShape shape = Qt::ArrowCursor;
+    };
+    QHash<QWaylandInputDevice *, CursorState> m_cursorStates;
 
-Q_DECLARE_OPERATORS_FOR_FLAGS(QAdwaitaDecorations::Buttons)
+    struct PendingMotion
+    {
+        QPointer<QWaylandInputDevice> inputDevice;
+        QPointF local;
+        Qt::MouseButtons buttons;
+    };
+    PendingMotion m_pendingMotion;
+    Qt::MouseButtons m_mouseButtons;
+    QElapsedTimer m_lastMotion;
+    QTimer m_motionTimer;
+};
 
 #endif // QADWAITA_DECORATIONS_H
@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitadecorationrenderer.h"
+#include "qadwaitaassets.h"
+#include "qadwaitaicontheme.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QThreadPool>
+
+#include <QtGui/QGuiApplication>
+#include <QtGui/QIcon>
+#include <QtGui/QPainter>
+
+#include <QtSvg/QSvgRenderer>
+
+#include <QtTest/QtTest>
+
+// Sizes are of the whole surface in device pixels, as on a screen of that resolution
+static const QSize ceSizes[] = { { 800, 600 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+static const qreal ceDevicePixelRatios[] = { 1.0, 1.5, 2.0 };
+// Layers are rendered at runtime for any scale without baked assets
+static const qreal ceLayerDevicePixelRatios[] = { 1.0, 1.25, 1.5, 1.75, 2.0, 3.0 };
+// Number of sizes a resize sweep goes through, each one a few pixels smaller
+static constexpr int ceSweepSteps = 32;
+
+// Paints the decorations into images the way a window does, from a newly opened
+// window to the repaints of a button being hovered
+class QAdwaitaDecorationsBench : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void coldCache_data();
+    void coldCache();
+    void steadyState_data();
+    void steadyState();
+    void hoverOnly_data();
+    void hoverOnly();
+    void resizeSweep_data();
+    void resizeSweep();
+
+    // Layers which are baked for the default look, rendered the way they are otherwise
+    void renderShadowTiles_data();
+    void renderShadowTiles();
+    void renderIconMask_data();
+    void renderIconMask();
+
+    // Not timed, checks the window border against the antialiased line it replaced
+    void roundedBorder_data();
+    void roundedBorder();
+
+private:
+    static void addRows(bool bakedColumn = false);
+    QAdwaitaDecorationRenderer::State fetchState() const;
+    std::unique_ptr<QAdwaitaDecorationRenderer> createRenderer(bool useBakedIcons = true) const;
+    QImage createImage() const;
+
+    QHash<QString, QByteArray> m_icons;
+};
+
+void QAdwaitaDecorationsBench::initTestCase()
+{
+    QAdwaitaIconTheme iconTheme(QIcon::themeSearchPaths());
+    for (const QString &iconName : QAdwaitaDecorationRenderer::iconNames()) {
+        QFile file(iconTheme.findIconPath({ QLatin1String("Adwaita") }, iconName));
+        if (file.open(QFile::ReadOnly))
+            m_icons.insert(iconName, file.readAll());
+        else
+            qWarning() << "Failed to find an svg icon for" << iconName;
+    }
+}
+
+// With the baked column, each row is added once with baked icons and once with
+// icons rendered from SVGs
+void QAdwaitaDecorationsBench::addRows(bool bakedColumn)
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("active");
+    QTest::addColumn<bool>("maximized");
+    QTest::addColumn<bool>("tiled");
+    QTest::addColumn<qreal>("devicePixelRatio");
+    if (bakedColumn)
+        QTest::addColumn<bool>("baked");
+
+    const QList<bool> bakedValues = bakedColumn ? QList<bool>{ true, false } : QList<bool>{ true };
+    for (const QSize &size : ceSizes) {
+        for (const bool active : { true, false }) {
+            for (const QString &mode : { QStringLiteral("normal"), QStringLiteral("maximized"),
+                                         QStringLiteral("tiled") }) {
+                for (const qreal devicePixelRatio : ceDevicePixelRatios) {
+                    for (const bool baked : bakedValues) {
+                        QString name = QStringLiteral("%1x%2 %3 %4 @%5")
+                                               .arg(size.width())
+                                               .arg(size.height())
+                                               .arg(QLatin1String(active ? "active" : "inactive"))
+                                               .arg(mode)
+                                               .arg(devicePixelRatio);
+                        if (bakedColumn)
+                            name += QLatin1String(baked ? " baked" : " runtime");
+
+                        QTestData &row = QTest::newRow(name.toUtf8().constData())
+                                << size << active << (mode == QLatin1String("maximized"))
+                                << (mode == QLatin1String("tiled")) << devicePixelRatio;
+                        if (bakedColumn)
+                            row << baked;
+                    }
+                }
+            }
+        }
+    }
+}
+
+QAdwaitaDecorationRenderer::State QAdwaitaDecorationsBench::fetchState() const
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, active);
+    QFETCH(bool, maximized);
+    QFETCH(bool, tiled);
+    QFETCH(qreal, devicePixelRatio);
+
+    QAdwaitaDecorationRenderer::State state;
+    state.size = size / devicePixelRatio;
+    state.active = active;
+    state.maximized = maximized;
+    // Tiled to the left half of the screen
+    if (tiled)
+        state.tiledEdges = Qt::LeftEdge | Qt::TopEdge | Qt::BottomEdge;
+    state.title = QStringLiteral("QAdwaitaDecorations benchmark");
+    state.colors = QAdwaitaDecorationRenderer::colors(false);
+    state.font = QFont(QLatin1String("Sans"), 10);
+    state.font.setBold(true);
+    state.buttons = { { QAdwaitaDecorationRenderer::Close, 1 },
+                      { QAdwaitaDecorationRenderer::Maximize, 2 },
+                      { QAdwaitaDecorationRenderer::Minimize, 3 } };
+    return state;
+}
+
+std::unique_ptr<QAdwaitaDecorationRenderer>
+QAdwaitaDecorationsBench::createRenderer(bool useBakedIcons) const
+{
+    auto renderer = std::make_unique<QAdwaitaDecorationRenderer>(useBakedIcons);
+    renderer->setIcons(m_icons);
+    return renderer;
+}
+
+QImage QAdwaitaDecorationsBench::createImage() const
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, devicePixelRatio);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::white);
+    return image;
+}
+
+// Layers rendered in worker threads are ready afterwards
+static void waitForLayers()
+{
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+}
+
+void QAdwaitaDecorationsBench::coldCache_data()
+{
+    addRows(true);
+}
+
+// A window opened while no other one exists, nothing is cached in the process.
+// Shadows for these colors and scales are always baked, renderShadowTiles covers
+// the blur.
+void QAdwaitaDecorationsBench::coldCache()
+{
+    QFETCH(bool, baked);
+    if (!baked && m_icons.isEmpty())
+        QSKIP("No svg icons found");
+
+    const QAdwaitaDecorationRenderer::State state = fetchState();
+    const QAdwaitaDecorationRenderer::Geometry geometry =
+            QAdwaitaDecorationRenderer::geometry(state);
+    QImage image = createImage();
+
+    QBENCHMARK {
+        const std::unique_ptr<QAdwaitaDecorationRenderer> renderer = createRenderer(baked);
+        QPainter painter(&image);
+        renderer->paint(&painter, state, geometry);
+    }
+    waitForLayers();
+}
+
+void QAdwaitaDecorationsBench::steadyState_data()
+{
+    addRows();
+}
+
+// Repaint of the whole decoration with all layers cached
+void QAdwaitaDecorationsBench::steadyState()
+{
+    const QAdwaitaDecorationRenderer::State state = fetchState();
+    const QAdwaitaDecorationRenderer::Geometry geometry =
+            QAdwaitaDecorationRenderer::geometry(state);
+    QImage image = createImage();
+    const std::unique_ptr<QAdwaitaDecorationRenderer> renderer = createRenderer();
+
+    {
+        QPainter painter(&image);
+        renderer->paint(&painter, state, geometry);
+    }
+    waitForLayers();
+
+    QBENCHMARK {
+        QPainter painter(&image);
+        renderer->paint(&painter, state, geometry);
+    }
+}
+
+void QAdwaitaDecorationsBench::hoverOnly_data()
+{
+    addRows();
+}
+
+// Repaint of a button going in and out of hover, clipped to the button
+void QAdwaitaDecorationsBench::hoverOnly()
+{
+    QAdwaitaDecorationRenderer::State state = fetchState();
+    const QAdwaitaDecorationRenderer::Geometry geometry =
+            QAdwaitaDecorationRenderer::geometry(state);
+    const QRect clipRect =
+            geometry.buttonRects.value(QAdwaitaDecorationRenderer::Close).toAlignedRect();
+    QImage image = createImage();
+    const std::unique_ptr<QAdwaitaDecorationRenderer> renderer = createRenderer();
+
+    for (const auto hoveredButtons :
+         { QAdwaitaDecorationRenderer::Buttons(QAdwaitaDecorationRenderer::Close),
+           QAdwaitaDecorationRenderer::Buttons(QAdwaitaDecorationRenderer::None) }) {
+        state.hoveredButtons = hoveredButtons;
+        QPainter painter(&image);
+        renderer->paint(&painter, state, geometry);
+    }
+    waitForLayers();
+
+    QBENCHMARK {
+        state.hoveredButtons ^= QAdwaitaDecorationRenderer::Close;
+        QPainter painter(&image);
+        painter.setClipRect(clipRect);
+        renderer->paint(&painter, state, geometry);
+    }
+}
+
+void QAdwaitaDecorationsBench::resizeSweep_data()
+{
+    addRows();
+}
+
+// Repaints while the window is being resized, each one with another size
+void QAdwaitaDecorationsBench::resizeSweep()
+{
+    const QAdwaitaDecorationRenderer::State initialState = fetchState();
+    QImage image = createImage();
+    const std::unique_ptr<QAdwaitaDecorationRenderer> renderer = createRenderer();
+
+    QVector<QAdwaitaDecorationRenderer::State> states;
+    for (int i = 0; i < ceSweepSteps; ++i) {
+        QAdwaitaDecorationRenderer::State state = initialState;
+        state.size -= QSize(8, 4) * i;
+        states.append(state);
+
+        QPainter painter(&image);
+        renderer->paint(&painter, state, QAdwaitaDecorationRenderer::geometry(state));
+    }
+    waitForLayers();
+
+    int step = 0;
+    QBENCHMARK {
+        const QAdwaitaDecorationRenderer::State &state = states.at(step++ % ceSweepSteps);
+        QPainter painter(&image);
+        renderer->paint(&painter, state, QAdwaitaDecorationRenderer::geometry(state));
+    }
+}
+
+void QAdwaitaDecorationsBench::renderShadowTiles_data()
+{
+    QTest::addColumn<QColor>("color");
+    QTest::addColumn<qreal>("devicePixelRatio");
+
+    for (const bool dark : { false, true }) {
+        const QColor color =
+                QAdwaitaDecorationRenderer::colors(dark).value(QAdwaitaDecorationRenderer::Border);
+        for (const qreal devicePixelRatio : ceLayerDevicePixelRatios) {
+            const QString name = QStringLiteral("%1 @%2")
+                                         .arg(QLatin1String(dark ? "dark" : "light"))
+                                         .arg(devicePixelRatio);
+            QTest::newRow(name.toUtf8().constData()) << color << devicePixelRatio;
+        }
+    }
+}
+
+void QAdwaitaDecorationsBench::renderShadowTiles()
+{
+    QFETCH(QColor, color);
+    QFETCH(qreal, devicePixelRatio);
+
+    QBENCHMARK {
+        QAdwaitaAssets::renderShadowTiles(color, devicePixelRatio);
+    }
+}
+
+void QAdwaitaDecorationsBench::renderIconMask_data()
+{
+    QTest::addColumn<QString>("iconName");
+    QTest::addColumn<qreal>("devicePixelRatio");
+
+    for (const QString &iconName : QAdwaitaDecorationRenderer::iconNames()) {
+        for (const qreal devicePixelRatio : ceLayerDevicePixelRatios) {
+            const QString name = QStringLiteral("%1 @%2").arg(iconName).arg(devicePixelRatio);
+            QTest::newRow(name.toUtf8().constData()) << iconName << devicePixelRatio;
+        }
+    }
+}
+
+// Parsed once like in the renderer, rendering again for each mask
+void QAdwaitaDecorationsBench::renderIconMask()
+{
+    QFETCH(QString, iconName);
+    QFETCH(qreal, devicePixelRatio);
+
+    QSvgRenderer renderer(m_icons.value(iconName));
+    if (!renderer.isValid())
+        QSKIP("No svg icon found");
+
+    QBENCHMARK {
+        QAdwaitaAssets::renderIconMask(&renderer, devicePixelRatio);
+    }
+}
+
+void QAdwaitaDecorationsBench::roundedBorder_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("dark");
+    QTest::addColumn<qreal>("devicePixelRatio");
+
+    for (const QSize &size : { QSize(800, 600), QSize(1920, 1080) }) {
+        for (const bool dark : { false, true }) {
+            // Fractional scales still stroke the border
+            for (const qreal devicePixelRatio : { 1.0, 2.0, 3.0 }) {
+                const QString name = QStringLiteral("%1x%2 %3 @%4")
+                                             .arg(size.width())
+                                             .arg(size.height())
+                                             .arg(QLatin1String(dark ? "dark" : "light"))
+                                             .arg(devicePixelRatio);
+                QTest::newRow(name.toUtf8().constData()) << size << dark << devicePixelRatio;
+            }
+        }
+    }
+}
+
+// Blending partial coverage rounds differently than the rasterizer does
+static bool fuzzyCompare(QRgb first, QRgb second)
+{
+    return qAbs(qRed(first) - qRed(second)) <= 2 && qAbs(qGreen(first) - qGreen(second)) <= 2
+            && qAbs(qBlue(first) - qBlue(second)) <= 2
+            && qAbs(qAlpha(first) - qAlpha(second)) <= 2;
+}
+
+// Inactive windows have no shadows, nothing but the border is painted below the
+// titlebar. The reference is the same image with the old stroke instead.
+void QAdwaitaDecorationsBench::roundedBorder()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, dark);
+    QFETCH(qreal, devicePixelRatio);
+
+    QAdwaitaDecorationRenderer::State state;
+    state.size = size / devicePixelRatio;
+    state.colors = QAdwaitaDecorationRenderer::colors(dark);
+    const QAdwaitaDecorationRenderer::Geometry geometry =
+            QAdwaitaDecorationRenderer::geometry(state);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        createRenderer()->paint(&painter, state, geometry);
+    }
+
+    const QColor backgroundColor =
+            state.colors.value(QAdwaitaDecorationRenderer::BackgroundInactive);
+    const QColor borderColor = state.colors.value(QAdwaitaDecorationRenderer::BorderInactive);
+    const QMargins &margins = geometry.margins;
+    const QMargins &shadowMargins = geometry.shadowMargins;
+    const int left = shadowMargins.left();
+    const int width = state.size.width() - shadowMargins.left() - shadowMargins.right();
+    const int top = margins.top();
+    const int bottom = state.size.height() - margins.bottom();
+
+    // Back to the last titlebar row as the titlebar slices leave it, then stroked
+    // like the border used to be
+    QImage reference = image.copy();
+    reference.setDevicePixelRatio(devicePixelRatio);
+    {
+        QPainter painter(&reference);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(QRect(0, top, state.size.width(), state.size.height() - top),
+                         Qt::transparent);
+        painter.fillRect(QRect(left, top - 1, width, 1), borderColor);
+        painter.fillRect(QRect(left + 1, top - 1, width - 2, 1), backgroundColor);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(borderColor);
+        painter.drawRect(QRectF(left + 0.5, top, width - 1, bottom - top));
+    }
+
+    // Window content covers the inner half of the line
+    const QRect contentRect = geometry.surfaceRect.marginsRemoved(margins);
+    const QRect deviceContentRect(contentRect.topLeft() * devicePixelRatio,
+                                  contentRect.size() * devicePixelRatio);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            if (deviceContentRect.contains(x, y))
+                continue;
+
+            const QRgb pixel = image.pixel(x, y);
+            const QRgb referencePixel = reference.pixel(x, y);
+            if (!fuzzyCompare(pixel, referencePixel)) {
+                const QString message = QStringLiteral("Pixel %1,%2 is %3 instead of %4")
+                                                .arg(x)
+                                                .arg(y)
+                                                .arg(pixel, 8, 16)
+                                                .arg(referencePixel, 8, 16);
+                QFAIL(message.toUtf8().constData());
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Nothing is shown, don't depend on a running compositor
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+    QAdwaitaDecorationsBench bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "qadwaitadecorationsbench.moc"
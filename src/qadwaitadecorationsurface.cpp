@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitadecorationsurface.h"
+
+#include <QtWaylandClient/private/qwaylanddisplay_p.h>
+#include <QtWaylandClient/private/qwaylandshmbackingstore_p.h>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
+
+#include <wayland-client-protocol.h>
+
+using namespace QtWaylandClient;
+
+QAdwaitaDecorationSurface::QAdwaitaDecorationSurface(QWaylandWindow *window) : m_window(window)
+{
+#if QT_VERSION >= 0x060500
+    QWaylandDisplay *display = window->display();
+    m_parentSurface = window->wlSurface();
+    if (!m_parentSurface || !display->subcompositor())
+        return;
+
+    m_surface = display->compositor()->create_surface();
+    m_subsurface = display->subcompositor()->get_subsurface(m_surface, m_parentSurface);
+
+    // Shadows overlap nothing but the window itself, which is fully drawn on top
+    wl_subsurface_set_position(m_subsurface, 0, 0);
+    wl_subsurface_place_below(m_subsurface, m_parentSurface);
+    wl_subsurface_set_desync(m_subsurface);
+
+    // Input is handled by the window surface
+    wl_region *inputRegion = display->createRegion(QRegion());
+    wl_surface_set_input_region(m_surface, inputRegion);
+    wl_region_destroy(inputRegion);
+#endif
+}
+
+QAdwaitaDecorationSurface::~QAdwaitaDecorationSurface()
+{
+    cancelParentCommitCallback();
+    if (m_subsurface)
+        wl_subsurface_destroy(m_subsurface);
+    if (m_surface)
+        wl_surface_destroy(m_surface);
+}
+
+bool QAdwaitaDecorationSurface::isEnabled()
+{
+#if QT_VERSION >= 0x060500
+    static const bool enabled = qEnvironmentVariableIntValue("QADWAITA_SUBSURFACE") != 0;
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+QImage *QAdwaitaDecorationSurface::beginPaint(const QSize &size, int scale)
+{
+#if QT_VERSION >= 0x060500
+    if (!isValid())
+        return nullptr;
+
+    if (scale != m_scale) {
+        m_scale = scale;
+        m_buffers[0].reset();
+        m_buffers[1].reset();
+    }
+
+    m_paintBuffer = nullptr;
+    for (auto &buffer : m_buffers) {
+        if (buffer && buffer->busy())
+            continue;
+        if (!buffer || buffer->size() != size * scale) {
+            buffer = std::make_unique<QWaylandShmBuffer>(
+                    m_window->display(), size * scale, QImage::Format_ARGB32_Premultiplied, scale);
+            m_damageAll = true;
+        }
+        m_paintBuffer = buffer.get();
+        break;
+    }
+
+    return m_paintBuffer ? m_paintBuffer->image() : nullptr;
+#else
+    Q_UNUSED(size)
+    Q_UNUSED(scale)
+    return nullptr;
+#endif
+}
+
+void QAdwaitaDecorationSurface::commit(const QRegion &damage, bool synchronized)
+{
+#if QT_VERSION >= 0x060500
+    if (!m_paintBuffer)
+        return;
+
+    // Window contents matching the synchronized state might not be committed yet,
+    // applying anything before them would show decorations of another size
+    if (synchronized)
+        setSynchronized(true);
+    else if (!m_parentCommitCallback)
+        setSynchronized(false);
+
+    m_paintBuffer->setBusy(true);
+    wl_surface_set_buffer_scale(m_surface, m_scale);
+    wl_surface_attach(m_surface, m_paintBuffer->buffer(), 0, 0);
+    if (m_damageAll) {
+        wl_surface_damage(m_surface, 0, 0, INT32_MAX, INT32_MAX);
+        m_damageAll = false;
+    } else {
+        for (const QRect &rect : damage)
+            wl_surface_damage(m_surface, rect.x(), rect.y(), rect.width(), rect.height());
+    }
+    wl_surface_commit(m_surface);
+    m_paintBuffer = nullptr;
+
+    if (synchronized)
+        requestParentCommitCallback();
+#else
+    Q_UNUSED(damage)
+    Q_UNUSED(synchronized)
+#endif
+}
+
+void QAdwaitaDecorationSurface::setSynchronized(bool synchronized)
+{
+    if (!m_subsurface || m_synchronized == synchronized)
+        return;
+
+    m_synchronized = synchronized;
+    if (synchronized)
+        wl_subsurface_set_sync(m_subsurface);
+    else
+        wl_subsurface_set_desync(m_subsurface);
+}
+
+void QAdwaitaDecorationSurface::requestParentCommitCallback()
+{
+    static const wl_callback_listener listener = { &QAdwaitaDecorationSurface::parentCommitted };
+
+    // A callback requested earlier might be part of a window commit which was done
+    // already, only the next one applies this state
+    cancelParentCommitCallback();
+
+    // Nothing is committed on the window surface here, Qt's next commit of the
+    // window contents includes the callback
+    m_parentCommitCallback = wl_surface_frame(m_parentSurface);
+    wl_callback_add_listener(m_parentCommitCallback, &listener, this);
+}
+
+void QAdwaitaDecorationSurface::cancelParentCommitCallback()
+{
+    if (!m_parentCommitCallback)
+        return;
+
+    wl_callback_destroy(m_parentCommitCallback);
+    m_parentCommitCallback = nullptr;
+}
+
+void QAdwaitaDecorationSurface::parentCommitted(void *data, wl_callback *callback, uint32_t time)
+{
+    Q_UNUSED(time)
+
+    auto *surface = static_cast<QAdwaitaDecorationSurface *>(data);
+    wl_callback_destroy(callback);
+    surface->m_parentCommitCallback = nullptr;
+
+    // Anything committed in the meantime is applied right away
+    surface->setSynchronized(false);
+}
+
+void QAdwaitaDecorationSurface::setOpaqueRegion(const QRegion &region)
+{
+    if (!m_surface)
+        return;
+
+    wl_region *opaqueRegion = m_window->display()->createRegion(region);
+    wl_surface_set_opaque_region(m_surface, opaqueRegion);
+    wl_region_destroy(opaqueRegion);
+}
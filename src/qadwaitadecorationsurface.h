@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_DECORATION_SURFACE_H
+#define QADWAITA_DECORATION_SURFACE_H
+
+#include <QtGui/QImage>
+#include <QtGui/QRegion>
+
+#include <memory>
+
+namespace QtWaylandClient {
+class QWaylandShmBuffer;
+class QWaylandWindow;
+} // namespace QtWaylandClient
+
+struct wl_callback;
+struct wl_subsurface;
+struct wl_surface;
+
+// Subsurface placed below the window surface the decorations are painted into
+// instead of the window buffer. It has its own double buffered shm buffers, so
+// repainting the decorations doesn't commit the window contents and the other
+// way around.
+class QAdwaitaDecorationSurface
+{
+public:
+    explicit QAdwaitaDecorationSurface(QtWaylandClient::QWaylandWindow *window);
+    ~QAdwaitaDecorationSurface();
+
+    // Whether subsurfaces are enabled and supported by the compositor
+    static bool isEnabled();
+
+    bool isValid() const { return m_subsurface != nullptr; }
+    wl_surface *surface() const { return m_surface; }
+    wl_surface *parentSurface() const { return m_parentSurface; }
+
+    // Returns the buffer to paint the next frame into, or nullptr when all
+    // buffers are still used by the compositor
+    QImage *beginPaint(const QSize &size, int scale);
+    // Synchronized commits are applied together with the next window commit. Until
+    // that one is done, later commits are synchronized as well.
+    void commit(const QRegion &damage, bool synchronized);
+    void setOpaqueRegion(const QRegion &region);
+
+private:
+    void setSynchronized(bool synchronized);
+    void requestParentCommitCallback();
+    void cancelParentCommitCallback();
+    static void parentCommitted(void *data, wl_callback *callback, uint32_t time);
+
+    QtWaylandClient::QWaylandWindow *m_window = nullptr;
+    wl_surface *m_parentSurface = nullptr;
+    wl_surface *m_surface = nullptr;
+    wl_subsurface *m_subsurface = nullptr;
+    bool m_synchronized = false;
+    // Frame callback of the window commit synchronized state is waiting for
+    wl_callback *m_parentCommitCallback = nullptr;
+
+    std::unique_ptr<QtWaylandClient::QWaylandShmBuffer> m_buffers[2];
+    QtWaylandClient::QWaylandShmBuffer *m_paintBuffer = nullptr;
+    int m_scale = 1;
+    // New buffers have no previous content, damage is ignored for them
+    bool m_damageAll = true;
+};
+
+#endif // QADWAITA_DECORATION_SURFACE_H
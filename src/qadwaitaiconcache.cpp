@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitaiconcache.h"
+#include "qadwaitalogging.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QVector>
+
+static constexpr quint32 ceCacheMagic = 0x51414943; // "QAIC"
+static constexpr quint32 ceCacheVersion = 2;
+// Plugins built with different Qt versions share the cache
+static constexpr QDataStream::Version ceStreamVersion = QDataStream::Qt_5_12;
+
+static QString cacheFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QLatin1String("/qadwaitadecorations/icons.cache");
+}
+
+// Modification time of every path, -1 for missing ones, so newly installed
+// themes and icons invalidate the cache as well
+static QVector<qint64> modificationTimes(const QStringList &paths)
+{
+    QVector<qint64> times;
+    times.reserve(paths.size());
+    for (const QString &path : paths) {
+        const QFileInfo fileInfo(path);
+        times << (fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : -1);
+    }
+    return times;
+}
+
+QAdwaitaIconCache::Entries QAdwaitaIconCache::load(const QStringList &themeNames,
+                                                   const QStringList &searchPaths)
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QFile::ReadOnly))
+        return {};
+
+    QDataStream stream(&file);
+    stream.setVersion(ceStreamVersion);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != ceCacheMagic || version != ceCacheVersion)
+        return {};
+
+    QStringList cachedThemeNames;
+    QStringList cachedSearchPaths;
+    QStringList paths;
+    QVector<qint64> times;
+    stream >> cachedThemeNames >> cachedSearchPaths >> paths >> times;
+    if (stream.status() != QDataStream::Ok || cachedThemeNames != themeNames
+        || cachedSearchPaths != searchPaths)
+        return {};
+
+    if (times != modificationTimes(paths)) {
+        qCDebug(QAdwaitaDecorationsLog) << "Icon themes changed, not using icon cache";
+        return {};
+    }
+
+    Entries entries;
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString iconName;
+        Entry entry;
+        stream >> iconName >> entry.path >> entry.svg;
+        entries.insert(iconName, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return {};
+
+    qCDebug(QAdwaitaDecorationsLog) << "Loaded " << entries.size() << " icons from "
+                                    << file.fileName();
+    return entries;
+}
+
+void QAdwaitaIconCache::save(const QStringList &themeNames, const QStringList &searchPaths,
+                             const QStringList &lookupPaths, const Entries &entries)
+{
+    const QString filePath = cacheFilePath();
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)) {
+        qCDebug(QAdwaitaDecorationsLog) << "Failed to write icon cache " << filePath;
+        return;
+    }
+
+    // Icons can be replaced without touching their directories
+    QStringList paths = lookupPaths;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (!it.value().path.isEmpty())
+            paths << it.value().path;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(ceStreamVersion);
+    stream << ceCacheMagic << ceCacheVersion;
+    stream << themeNames << searchPaths << paths << modificationTimes(paths);
+
+    stream << quint32(entries.size());
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+        stream << it.key() << it.value().path << it.value().svg;
+
+    file.commit();
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_ICON_CACHE_H
+#define QADWAITA_ICON_CACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+// Persistent cache of resolved button icons stored under $XDG_CACHE_HOME. The
+// content is only used as long as none of the icon theme directories and index
+// files it was created from, nor the icon files, changed, which is checked using
+// their modification times.
+class QAdwaitaIconCache
+{
+public:
+    struct Entry
+    {
+        QString path;
+        QByteArray svg;
+    };
+    using Entries = QHash<QString, Entry>;
+
+    static Entries load(const QStringList &themeNames, const QStringList &searchPaths);
+    static void save(const QStringList &themeNames, const QStringList &searchPaths,
+                     const QStringList &lookupPaths, const Entries &entries);
+};
+
+#endif // QADWAITA_ICON_CACHE_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitaiconstore.h"
+#include "qadwaitaicontheme.h"
+#include "qadwaitalogging.h"
+
+#include <QtCore/QFile>
+
+#include <QtGui/QIcon>
+
+static QStringList iconThemeNames()
+{
+    return { QIcon::themeName(), QIcon::fallbackThemeName(), QLatin1String("Adwaita") };
+}
+
+// Runs in a worker thread, must not touch anything but its arguments
+static QAdwaitaIconCache::Entries loadIcons(const QStringList &themeNames,
+                                            const QStringList &searchPaths,
+                                            const QStringList &iconNames,
+                                            const QAdwaitaIconCache::Entries &knownIcons)
+{
+    QAdwaitaIconCache::Entries entries = QAdwaitaIconCache::load(themeNames, searchPaths);
+    QAdwaitaIconTheme iconTheme(searchPaths);
+
+    bool cacheChanged = false;
+    for (const QString &iconName : iconNames) {
+        if (entries.contains(iconName))
+            continue;
+
+        QAdwaitaIconCache::Entry entry;
+        entry.path = iconTheme.findIconPath(themeNames, iconName);
+        if (!entry.path.isEmpty()) {
+            QFile readFile(entry.path);
+            if (readFile.open(QFile::ReadOnly))
+                entry.svg = readFile.readAll();
+        } else {
+            qCWarning(QAdwaitaDecorationsLog) << "Failed to find an svg icon for " << iconName;
+        }
+
+        entries.insert(iconName, entry);
+        cacheChanged = true;
+    }
+
+    if (cacheChanged) {
+        for (auto it = knownIcons.constBegin(); it != knownIcons.constEnd(); ++it) {
+            if (!entries.contains(it.key()))
+                entries.insert(it.key(), it.value());
+        }
+        QAdwaitaIconCache::save(themeNames, searchPaths, iconTheme.lookupPaths(themeNames),
+                                entries);
+    }
+
+    return entries;
+}
+
+void QAdwaitaIconStore::load(const QStringList &iconNames)
+{
+    const QStringList themeNames = iconThemeNames();
+    const QStringList searchPaths = QIcon::themeSearchPaths();
+    if (m_themeNames != themeNames || m_searchPaths != searchPaths) {
+        qCDebug(QAdwaitaDecorationsLog) << "Icon theme changed, dropping cached icons";
+        m_themeNames = themeNames;
+        m_searchPaths = searchPaths;
+        m_pendingIconNames.clear();
+        m_icons.clear();
+    }
+
+    QStringList missingIconNames;
+    for (const QString &iconName : iconNames) {
+        if (!m_icons.contains(iconName) && !m_pendingIconNames.contains(iconName))
+            missingIconNames << iconName;
+    }
+
+    if (missingIconNames.isEmpty())
+        return;
+
+    m_pendingIconNames << missingIconNames;
+
+    const QAdwaitaIconCache::Entries knownIcons = m_icons;
+    runInWorkerThread(
+            [themeNames, searchPaths, missingIconNames, knownIcons]() {
+                return loadIcons(themeNames, searchPaths, missingIconNames, knownIcons);
+            },
+            [themeNames, searchPaths](QAdwaitaIconStore *store,
+                                      const QAdwaitaIconCache::Entries &entries) {
+                store->iconsLoaded(themeNames, searchPaths, entries);
+            });
+}
+
+QHash<QString, QByteArray> QAdwaitaIconStore::icons() const
+{
+    QHash<QString, QByteArray> icons;
+    for (auto it = m_icons.constBegin(); it != m_icons.constEnd(); ++it)
+        icons.insert(it.key(), it.value().svg);
+    return icons;
+}
+
+void QAdwaitaIconStore::iconsLoaded(const QStringList &themeNames, const QStringList &searchPaths,
+                                    const QAdwaitaIconCache::Entries &entries)
+{
+    // Icon theme changed while loading
+    if (m_themeNames != themeNames || m_searchPaths != searchPaths)
+        return;
+
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        m_icons.insert(it.key(), it.value());
+        m_pendingIconNames.removeAll(it.key());
+    }
+
+    Q_EMIT iconsChanged();
+}
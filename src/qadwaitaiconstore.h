@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_ICON_STORE_H
+#define QADWAITA_ICON_STORE_H
+
+#include "qadwaitaiconcache.h"
+#include "qadwaitasharedobject.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+// Process-wide storage of the SVG icons used for titlebar buttons. It is shared
+// by all decoration instances, see QAdwaitaSharedObject, so icon themes are
+// searched only once and again only after the icon theme changes.
+// Icons are searched and read in a worker thread, iconsChanged() is emitted once
+// they are available.
+class QAdwaitaIconStore : public QObject, public QAdwaitaSharedObject<QAdwaitaIconStore>
+{
+    Q_OBJECT
+public:
+    void load(const QStringList &iconNames);
+    QHash<QString, QByteArray> icons() const;
+
+Q_SIGNALS:
+    void iconsChanged();
+
+private:
+    friend class QAdwaitaSharedObject<QAdwaitaIconStore>;
+    QAdwaitaIconStore() = default;
+
+    void iconsLoaded(const QStringList &themeNames, const QStringList &searchPaths,
+                     const QAdwaitaIconCache::Entries &entries);
+
+    QStringList m_themeNames;
+    QStringList m_searchPaths;
+    QStringList m_pendingIconNames;
+    QAdwaitaIconCache::Entries m_icons;
+};
+
+#endif // QADWAITA_ICON_STORE_H
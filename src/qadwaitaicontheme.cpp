@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitaicontheme.h"
+#include "qadwaitalogging.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <algorithm>
+
+// Size the button icons are designed for
+static constexpr int ceIconSize = 16;
+
+using IndexGroups = QHash<QString, QHash<QString, QString>>;
+
+static IndexGroups parseIndexFile(const QString &fileName)
+{
+    IndexGroups groups;
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(QAdwaitaDecorationsLog) << "Failed to open " << fileName;
+        return groups;
+    }
+
+    QString group;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        if (line.startsWith(QLatin1Char('[')) && line.endsWith(QLatin1Char(']'))) {
+            group = line.mid(1, line.size() - 2);
+            continue;
+        }
+
+        const int separator = line.indexOf(QLatin1Char('='));
+        if (separator > 0)
+            groups[group].insert(line.left(separator).trimmed(), line.mid(separator + 1).trimmed());
+    }
+
+    return groups;
+}
+
+QAdwaitaIconTheme::QAdwaitaIconTheme(const QStringList &searchPaths) : m_searchPaths(searchPaths)
+{
+}
+
+const QAdwaitaIconTheme::Theme &QAdwaitaIconTheme::theme(const QString &themeName)
+{
+    auto it = m_themes.constFind(themeName);
+    if (it != m_themes.constEnd())
+        return it.value();
+
+    Theme theme;
+    QString indexFile;
+    for (const QString &path : m_searchPaths) {
+        if (path.startsWith(QLatin1Char(':')))
+            continue;
+
+        const QString baseDir = QString("%1/%2").arg(path).arg(themeName);
+        if (!QFileInfo(baseDir).isDir())
+            continue;
+
+        theme.baseDirs << baseDir;
+        if (indexFile.isEmpty() && QFileInfo::exists(baseDir + QLatin1String("/index.theme")))
+            indexFile = baseDir + QLatin1String("/index.theme");
+    }
+
+    if (!indexFile.isEmpty()) {
+        const IndexGroups groups = parseIndexFile(indexFile);
+        const QHash<QString, QString> themeGroup = groups.value(QLatin1String("Icon Theme"));
+
+        theme.inherits = themeGroup.value(QLatin1String("Inherits"))
+                                 .split(QLatin1Char(','), Qt::SkipEmptyParts);
+
+        const QStringList directories = themeGroup.value(QLatin1String("Directories"))
+                                                .split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &directory : directories) {
+            const QHash<QString, QString> directoryGroup = groups.value(directory.trimmed());
+
+            // Window buttons are either action or UI icons
+            const QString context = directoryGroup.value(QLatin1String("Context"));
+            if (!context.isEmpty() && context != QLatin1String("Actions")
+                && context != QLatin1String("UI"))
+                continue;
+
+            Directory dir;
+            dir.name = directory.trimmed();
+            dir.size = directoryGroup.value(QLatin1String("Size")).toInt();
+            dir.scalable = directoryGroup.value(QLatin1String("Type")) == QLatin1String("Scalable");
+            theme.directories << dir;
+        }
+
+        // Scalable directories first, then the ones closest to the icon size
+        std::stable_sort(theme.directories.begin(), theme.directories.end(),
+                         [](const Directory &a, const Directory &b) {
+                             if (a.scalable != b.scalable)
+                                 return a.scalable;
+                             return qAbs(a.size - ceIconSize) < qAbs(b.size - ceIconSize);
+                         });
+    }
+
+    qCDebug(QAdwaitaDecorationsLog) << "Loaded icon theme " << themeName << " from "
+                                    << theme.baseDirs << " with " << theme.directories.size()
+                                    << " candidate directories";
+
+    return m_themes.insert(themeName, theme).value();
+}
+
+void QAdwaitaIconTheme::appendThemeChain(const QString &themeName, QStringList *chain)
+{
+    if (themeName.isEmpty() || chain->contains(themeName))
+        return;
+
+    chain->append(themeName);
+
+    // Copy, loading inherited themes modifies m_themes
+    const QStringList inherits = theme(themeName).inherits;
+    for (const QString &inherited : inherits)
+        appendThemeChain(inherited.trimmed(), chain);
+}
+
+QStringList QAdwaitaIconTheme::themeChain(const QStringList &themeNames)
+{
+    QStringList chain;
+    for (const QString &themeName : themeNames)
+        appendThemeChain(themeName, &chain);
+    appendThemeChain(QLatin1String("hicolor"), &chain);
+    return chain;
+}
+
+QStringList QAdwaitaIconTheme::lookupPaths(const QStringList &themeNames)
+{
+    QStringList paths;
+    for (const QString &themeName : themeChain(themeNames)) {
+        const Theme &iconTheme = theme(themeName);
+        for (const QString &path : m_searchPaths) {
+            if (path.startsWith(QLatin1Char(':')))
+                continue;
+
+            const QString baseDir = QString("%1/%2").arg(path).arg(themeName);
+            paths << baseDir << baseDir + QLatin1String("/index.theme");
+            if (!iconTheme.baseDirs.contains(baseDir))
+                continue;
+
+            for (const Directory &directory : iconTheme.directories)
+                paths << QString("%1/%2").arg(baseDir, directory.name);
+        }
+    }
+    return paths;
+}
+
+QString QAdwaitaIconTheme::findIconPath(const QStringList &themeNames, const QString &iconName)
+{
+    const QString key = themeNames.join(QLatin1Char(':')) + QLatin1Char('/') + iconName;
+    auto it = m_iconPaths.constFind(key);
+    if (it != m_iconPaths.constEnd())
+        return it.value();
+
+    const QStringList chain = themeChain(themeNames);
+    const QString fileName = iconName + QLatin1String(".svg");
+    auto lookup = [this, &chain, &fileName]() -> QString {
+        for (const QString &themeName : chain) {
+            const Theme &iconTheme = theme(themeName);
+            for (const Directory &directory : iconTheme.directories) {
+                for (const QString &baseDir : iconTheme.baseDirs) {
+                    const QString filePath =
+                            QString("%1/%2/%3").arg(baseDir, directory.name, fileName);
+                    if (QFileInfo::exists(filePath)) {
+                        qCDebug(QAdwaitaDecorationsLog)
+                                << "Using " << fileName << " from " << themeName << " theme";
+                        return filePath;
+                    }
+                }
+            }
+        }
+        return QString();
+    };
+
+    const QString filePath = lookup();
+    m_iconPaths.insert(key, filePath);
+    return filePath;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_ICON_THEME_H
+#define QADWAITA_ICON_THEME_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+// Icon lookup following the freedesktop icon theme specification, reduced to
+// what the titlebar buttons need. Only directories listed in index.theme that
+// can hold symbolic action icons are probed and every result is remembered.
+// Doesn't touch any global state, so it can be used from any thread.
+class QAdwaitaIconTheme
+{
+public:
+    explicit QAdwaitaIconTheme(const QStringList &searchPaths);
+
+    QString findIconPath(const QStringList &themeNames, const QString &iconName);
+    QStringList themeChain(const QStringList &themeNames);
+    // Every directory icons are looked up in and the index files, including
+    // missing ones, as their changes affect the lookup results
+    QStringList lookupPaths(const QStringList &themeNames);
+
+private:
+    struct Directory
+    {
+        QString name;
+        int size = 0;
+        bool scalable = false;
+    };
+
+    struct Theme
+    {
+        QStringList baseDirs;
+        QStringList inherits;
+        // Sorted from the best match for a symbolic icon
+        QVector<Directory> directories;
+    };
+
+    const Theme &theme(const QString &themeName);
+    void appendThemeChain(const QString &themeName, QStringList *chain);
+
+    QStringList m_searchPaths;
+    QHash<QString, Theme> m_themes;
+    QHash<QString, QString> m_iconPaths;
+};
+
+#endif // QADWAITA_ICON_THEME_H
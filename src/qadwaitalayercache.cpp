@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "qadwaitalayercache.h"
+#include "qadwaitaassets.h"
+#include "qadwaitalogging.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <QtSvg/QSvgRenderer>
+
+// Slow layers are timed with debug output enabled, one line per render which is
+// easy to collect for comparing releases
+template<typename Render>
+static QImage timedRender(const char *layer, qreal devicePixelRatio, Render render)
+{
+    if (!QAdwaitaDecorationsLog().isDebugEnabled())
+        return render();
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage image = render();
+    qCDebug(QAdwaitaDecorationsLog, "render layer=%s dpr=%.2f usec=%lld", layer, devicePixelRatio,
+            timer.nsecsElapsed() / 1000);
+    return image;
+}
+
+QPixmap QAdwaitaLayerCache::shadowTiles(const QColor &color, qreal devicePixelRatio)
+{
+    const QRgb rgba = color.rgba();
+    const auto key = std::make_pair(rgba, devicePixelRatio);
+    auto it = m_shadowTiles.constFind(key);
+    if (it != m_shadowTiles.constEnd())
+        return it.value();
+
+    // Blurring is slow, only the very first shadow is rendered right away
+    QImage image = QAdwaitaAssets::bakedShadowTiles(color, devicePixelRatio);
+    if (image.isNull() && m_shadowTiles.isEmpty()) {
+        image = timedRender("shadow", devicePixelRatio, [&color, devicePixelRatio]() {
+            return QAdwaitaAssets::renderShadowTiles(color, devicePixelRatio);
+        });
+    }
+
+    if (!image.isNull()) {
+        it = m_shadowTiles.insert(key, QPixmap::fromImage(image));
+        return it.value();
+    }
+
+    if (!m_pendingShadowTiles.contains(key)) {
+        m_pendingShadowTiles.append(key);
+        runInWorkerThread(
+                [rgba, devicePixelRatio]() {
+                    return timedRender("shadow", devicePixelRatio, [rgba, devicePixelRatio]() {
+                        return QAdwaitaAssets::renderShadowTiles(QColor::fromRgba(rgba),
+                                                                 devicePixelRatio);
+                    });
+                },
+                [key](QAdwaitaLayerCache *cache, const QImage &image) {
+                    cache->m_pendingShadowTiles.removeOne(key);
+                    cache->m_shadowTiles.insert(key, QPixmap::fromImage(image));
+                    Q_EMIT cache->shadowTilesRendered(key.first, key.second);
+                });
+    }
+    return QPixmap();
+}
+
+QImage QAdwaitaLayerCache::iconMask(const QByteArray &svgIcon, QSvgRenderer *renderer,
+                                    qreal devicePixelRatio)
+{
+    const auto key = std::make_pair(svgIcon, devicePixelRatio);
+    auto it = m_iconMasks.constFind(key);
+    if (it != m_iconMasks.constEnd())
+        return it.value();
+
+    // Rendering SVGs is slow, only the first mask of each icon is rendered right
+    // away, e.g. a new device pixel ratio gets its own masks in a worker thread
+    if (placeholderIconMask(svgIcon).isNull()) {
+        const QImage mask = timedRender("icon", devicePixelRatio, [renderer, devicePixelRatio]() {
+            return QAdwaitaAssets::renderIconMask(renderer, devicePixelRatio);
+        });
+        m_iconMasks.insert(key, mask);
+        return mask;
+    }
+
+    if (!m_pendingIconMasks.contains(key)) {
+        m_pendingIconMasks.append(key);
+        // Renderers are not thread-safe, the worker parses the icon on its own
+        runInWorkerThread(
+                [svgIcon, devicePixelRatio]() {
+                    return timedRender("icon", devicePixelRatio, [&svgIcon, devicePixelRatio]() {
+                        QSvgRenderer renderer(svgIcon);
+                        return QAdwaitaAssets::renderIconMask(&renderer, devicePixelRatio);
+                    });
+                },
+                [key](QAdwaitaLayerCache *cache, const QImage &mask) {
+                    cache->m_pendingIconMasks.removeOne(key);
+                    cache->m_iconMasks.insert(key, mask);
+                    Q_EMIT cache->iconMaskRendered(key.first, key.second);
+                });
+    }
+    return QImage();
+}
+
+QPixmap QAdwaitaLayerCache::placeholderShadowTiles(const QColor &color) const
+{
+    // Prefer the same color, a scaled shadow is harder to spot than a wrong color
+    for (auto it = m_shadowTiles.constBegin(); it != m_shadowTiles.constEnd(); ++it) {
+        if (it.key().first == color.rgba())
+            return it.value();
+    }
+    return m_shadowTiles.isEmpty() ? QPixmap() : m_shadowTiles.first();
+}
+
+QImage QAdwaitaLayerCache::placeholderIconMask(const QByteArray &svgIcon) const
+{
+    for (auto it = m_iconMasks.constBegin(); it != m_iconMasks.constEnd(); ++it) {
+        if (it.key().first == svgIcon)
+            return it.value();
+    }
+    return QImage();
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_LAYER_CACHE_H
+#define QADWAITA_LAYER_CACHE_H
+
+#include "qadwaitasharedobject.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtGui/QColor>
+#include <QtGui/QImage>
+#include <QtGui/QPixmap>
+
+#include <memory>
+#include <utility>
+
+class QSvgRenderer;
+
+// Process-wide storage of the decoration layers which are slow to render, shadow
+// tiles by color and icon masks by icon, both for each device pixel ratio. It is
+// shared by all renderers, see QAdwaitaSharedObject. Only the first layer of its
+// kind in the process is rendered right away, anything else is rendered in a
+// worker thread and announced once it's ready.
+class QAdwaitaLayerCache : public QObject, public QAdwaitaSharedObject<QAdwaitaLayerCache>
+{
+    Q_OBJECT
+public:
+    // Return a null layer while it's being rendered
+    QPixmap shadowTiles(const QColor &color, qreal devicePixelRatio);
+    // Renderer has to be parsed from the same icon, it's used only when rendering right away
+    QImage iconMask(const QByteArray &svgIcon, QSvgRenderer *renderer, qreal devicePixelRatio);
+
+    // Layers rendered with other parameters to be scaled or recolored until the
+    // requested ones are ready, null when there are none yet
+    QPixmap placeholderShadowTiles(const QColor &color) const;
+    QImage placeholderIconMask(const QByteArray &svgIcon) const;
+
+Q_SIGNALS:
+    void shadowTilesRendered(QRgb color, qreal devicePixelRatio);
+    void iconMaskRendered(const QByteArray &svgIcon, qreal devicePixelRatio);
+
+private:
+    friend class QAdwaitaSharedObject<QAdwaitaLayerCache>;
+    QAdwaitaLayerCache() = default;
+
+    QMap<std::pair<QRgb, qreal>, QPixmap> m_shadowTiles;
+    QList<std::pair<QRgb, qreal>> m_pendingShadowTiles;
+    QMap<std::pair<QByteArray, qreal>, QImage> m_iconMasks;
+    QList<std::pair<QByteArray, qreal>> m_pendingIconMasks;
+};
+
+#endif // QADWAITA_LAYER_CACHE_H
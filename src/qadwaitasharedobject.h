@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef QADWAITA_SHARED_OBJECT_H
+#define QADWAITA_SHARED_OBJECT_H
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThreadPool>
+
+#include <memory>
+
+// Base of process-wide objects shared by all decorations. Only users hold strong
+// references, the object goes away with the last one and is created again for
+// the next one. Objects live in the main thread and have to be destroyed there,
+// so work handed to worker threads never keeps them alive.
+template<typename T>
+class QAdwaitaSharedObject : public std::enable_shared_from_this<T>
+{
+public:
+    static std::shared_ptr<T> instance()
+    {
+        static std::weak_ptr<T> s_instance;
+
+        std::shared_ptr<T> object = s_instance.lock();
+        if (!object) {
+            object = std::shared_ptr<T>(new T);
+            s_instance = object;
+        }
+        return object;
+    }
+
+protected:
+    // The work runs in a worker thread and must not touch anything but its own
+    // captures. Its result is handed to done in the main thread, unless the object
+    // was destroyed in the meantime.
+    template<typename Work, typename Done>
+    void runInWorkerThread(Work work, Done done)
+    {
+        const std::weak_ptr<T> weakObject = this->shared_from_this();
+        QThreadPool::globalInstance()->start([weakObject, work, done]() {
+            const auto result = work();
+            // The object is looked up only once the result is delivered
+            QMetaObject::invokeMethod(
+                    QCoreApplication::instance(),
+                    [weakObject, done, result]() {
+                        if (std::shared_ptr<T> object = weakObject.lock())
+                            done(object.get(), result);
+                    },
+                    Qt::QueuedConnection);
+        });
+    }
+};
+
+#endif // QADWAITA_SHARED_OBJECT_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2023 Jan Grulich <jgrulich@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <QtGui/QGuiApplication>
+#include <QtGui/QPainter>
+#include <QtGui/QRasterWindow>
+
+#include <QtWaylandClient/private/qwaylandabstractdecoration_p.h>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
+
+#include <QtTest/QtTest>
+
+// Plain window counting its paints, each one is a commit of the window surface
+class TestWindow : public QRasterWindow
+{
+public:
+    int paintCount = 0;
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event)
+        QPainter painter(this);
+        painter.fillRect(QRect(QPoint(), size()), paintCount % 2 ? Qt::darkGray : Qt::lightGray);
+        ++paintCount;
+    }
+};
+
+// Runs against a real compositor, see run-with-weston.sh. A protocol error ends the
+// connection and the test with it, anything else is checked by the window still
+// getting exposed and painted.
+class QAdwaitaDecorationsSmokeTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void showAndResize();
+    void maximizeAndRestore();
+
+private:
+    static void resizeAndWait(TestWindow *window, const QSize &size);
+};
+
+void QAdwaitaDecorationsSmokeTest::initTestCase()
+{
+    if (QGuiApplication::platformName() != QLatin1String("wayland"))
+        QSKIP("Needs a Wayland compositor");
+}
+
+void QAdwaitaDecorationsSmokeTest::resizeAndWait(TestWindow *window, const QSize &size)
+{
+    const int paintCount = window->paintCount;
+    window->resize(size);
+    QTRY_VERIFY(window->paintCount > paintCount);
+    QCOMPARE(window->size(), size);
+}
+
+void QAdwaitaDecorationsSmokeTest::showAndResize()
+{
+    TestWindow window;
+    window.resize(400, 300);
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    auto *waylandWindow = static_cast<QtWaylandClient::QWaylandWindow *>(window.handle());
+    QVERIFY(waylandWindow->decoration());
+    QVERIFY(waylandWindow->decoration()->inherits("QAdwaitaDecorations"));
+    QVERIFY(!window.frameMargins().isNull());
+
+    // Every resize commits decorations of a new size together with the contents
+    for (int i = 1; i <= 20; ++i)
+        resizeAndWait(&window, QSize(400 + 10 * i, 300 + 5 * i));
+    for (int i = 19; i >= 0; --i)
+        resizeAndWait(&window, QSize(400 + 10 * i, 300 + 5 * i));
+
+    // Decorations are repainted without the contents in between
+    window.setTitle(QStringLiteral("QAdwaitaDecorations smoke test"));
+    QTest::qWait(100);
+    QVERIFY(window.isExposed());
+}
+
+void QAdwaitaDecorationsSmokeTest::maximizeAndRestore()
+{
+    TestWindow window;
+    window.resize(400, 300);
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    // Decorations lose their shadows and rounded corners, the surface changes size
+    // with the contents
+    window.showMaximized();
+    QTRY_VERIFY(window.windowStates() & Qt::WindowMaximized);
+    QTRY_VERIFY(window.width() > 400);
+
+    window.showNormal();
+    QTRY_COMPARE(window.size(), QSize(400, 300));
+    QVERIFY(window.isExposed());
+}
+
+QTEST_MAIN(QAdwaitaDecorationsSmokeTest)
+
+#include "qadwaitadecorationssmoketest.moc"
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Runs a test client against a headless Weston, loading the decoration plugin
+# from the build tree.
+#
+# Usage: run-with-weston.sh <weston> <plugin> <test> [arguments]
+
+set -e
+
+weston=$1
+plugin=$2
+shift 2
+
+runtime_dir=$(mktemp -d)
+weston_pid=
+cleanup() {
+    if [ -n "$weston_pid" ]; then
+        kill "$weston_pid" 2>/dev/null || true
+        wait "$weston_pid" 2>/dev/null || true
+    fi
+    rm -rf "$runtime_dir"
+}
+trap cleanup EXIT
+
+mkdir -p "$runtime_dir/plugins/wayland-decoration-client"
+ln -s "$plugin" "$runtime_dir/plugins/wayland-decoration-client/"
+
+export XDG_RUNTIME_DIR="$runtime_dir"
+"$weston" --backend=headless-backend.so --socket=wayland-test --idle-time=0 \
+    --log="$runtime_dir/weston.log" &
+weston_pid=$!
+
+# Weston creates the socket once it's ready for clients
+tries=0
+while [ ! -S "$runtime_dir/wayland-test" ]; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 100 ] || ! kill -0 "$weston_pid" 2>/dev/null; then
+        echo "Weston failed to start:" >&2
+        cat "$runtime_dir/weston.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+WAYLAND_DISPLAY=wayland-test \
+QT_QPA_PLATFORM=wayland \
+QT_WAYLAND_DECORATION=adwaita \
+QT_PLUGIN_PATH="$runtime_dir/plugins" \
+    "$@"